@@ -0,0 +1,75 @@
+#include "ExportJob.h"
+#include "TaskDatabase.h"
+#include <QtConcurrent>
+
+ExportJob::ExportJob(Format format, const QString& filePath, QObject *parent)
+    : QObject(parent)
+    , m_format(format)
+    , m_filePath(filePath)
+    , m_progress(std::make_shared<ExportProgress>())
+{
+    // 导出使用任务自己的线程池，避免长时间导出占满全局线程池而拖慢后台搜索
+    m_pool.setMaxThreadCount(1);
+    m_progressTimer.setInterval(100);
+    connect(&m_progressTimer, &QTimer::timeout, this, &ExportJob::reportProgress);
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, [this]() {
+        m_progressTimer.stop();
+        reportProgress();
+        const bool success = m_watcher.result();
+        emit finished(success, !success && m_progress->cancelled.load());
+    });
+}
+
+ExportJob::~ExportJob()
+{
+    // 导出在下一批行处检查取消标志，等它结束再析构，工作线程不会比任务对象活得更久
+    cancel();
+    wait();
+}
+
+void ExportJob::wait()
+{
+    m_watcher.waitForFinished();
+    m_pool.waitForDone();
+}
+
+void ExportJob::start()
+{
+    if (m_watcher.isRunning()) {
+        return;
+    }
+    m_progressTimer.start();
+    m_watcher.setFuture(QtConcurrent::run(&m_pool, &ExportJob::run, m_format, m_filePath, m_progress));
+}
+
+void ExportJob::cancel()
+{
+    m_progress->cancelled.store(true);
+}
+
+void ExportJob::reportProgress()
+{
+    const qint64 rows = m_progress->rows.load(std::memory_order_relaxed);
+    const qint64 bytes = m_progress->bytes.load(std::memory_order_relaxed);
+    if (rows != m_reportedRows || bytes != m_reportedBytes) {
+        m_reportedRows = rows;
+        m_reportedBytes = bytes;
+        emit progressChanged(rows, bytes);
+    }
+}
+
+bool ExportJob::run(Format format, const QString& filePath, std::shared_ptr<ExportProgress> progress)
+{
+    bool success = false;
+    {
+        ExportManager manager;
+        if (format == PdfFormat) {
+            success = manager.exportToPdf(filePath, progress.get());
+        } else {
+            success = manager.exportToExcel(filePath, progress.get());
+        }
+    }
+    // 线程池中的线程随任务一起结束，先移除本线程的数据库连接
+    TaskDatabase::getInstance()->releaseThreadConnection();
+    return success;
+}
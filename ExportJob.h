@@ -0,0 +1,56 @@
+#ifndef EXPORTJOB_H
+#define EXPORTJOB_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <memory>
+#include "ExportManager.h"
+
+// 后台导出任务：在任务自己的线程池中运行 ExportManager，定时汇报进度，支持协作式取消。
+// 工作线程只持有共享的 ExportProgress，不引用本对象；析构时取消并等待导出结束。
+class ExportJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format {
+        ExcelFormat,
+        PdfFormat
+    };
+
+    ExportJob(Format format, const QString& filePath, QObject *parent = nullptr);
+    ~ExportJob() override;
+
+    void start();
+    bool isRunning() const { return m_watcher.isRunning(); }
+    // 阻塞等待导出结束
+    void wait();
+
+    Format format() const { return m_format; }
+    QString filePath() const { return m_filePath; }
+
+public slots:
+    void cancel();
+
+signals:
+    void progressChanged(qint64 rows, qint64 bytes);
+    // cancelled 为 true 时 success 一定为 false，未完成的文件已删除
+    void finished(bool success, bool cancelled);
+
+private:
+    void reportProgress();
+    static bool run(Format format, const QString& filePath, std::shared_ptr<ExportProgress> progress);
+
+    Format m_format;
+    QString m_filePath;
+    std::shared_ptr<ExportProgress> m_progress;
+    QThreadPool m_pool; // 先于 m_watcher 声明，最后析构
+    QFutureWatcher<bool> m_watcher;
+    QTimer m_progressTimer;
+    qint64 m_reportedRows = -1;
+    qint64 m_reportedBytes = -1;
+};
+
+#endif // EXPORTJOB_H
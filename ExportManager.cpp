@@ -1,16 +1,137 @@
 #include "TaskDatabase.h"   // 提供 Task/Category 定义
 #include "ExportManager.h"
 #include <QPrinter>
-#include <QPainter>
-#include <QTextDocument>
 #include <QDebug>
 #include <QPageSize>
 #include <QPageLayout>
 #include <QDateTime>
 #include <QFileInfo>
 #include <QDir>
-#include <xlsxdocument.h>
-#include <xlsxworksheet.h>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include <memory>
+#include "PdfReportRenderer.h"
+#include "XlsxStreamWriter.h"
+
+namespace {
+// 每隔多少行更新一次进度并检查取消标志
+const int kProgressInterval = 256;
+
+// 读快照：导出期间保持一个读事务，所有查询看到同一份数据；
+// 数据库为 WAL 模式，读事务不会阻塞界面线程的写入
+class ReadSnapshot
+{
+public:
+    explicit ReadSnapshot(QSqlDatabase db)
+        : m_db(db), m_active(m_db.transaction())
+    {
+        if (!m_active) {
+            qWarning() << "开启导出读事务失败：" << m_db.lastError().text();
+        }
+    }
+    ~ReadSnapshot()
+    {
+        if (m_active) {
+            m_db.rollback();
+        }
+    }
+
+private:
+    QSqlDatabase m_db;
+    bool m_active;
+};
+
+bool isCancelled(const ExportProgress* progress)
+{
+    return progress && progress->cancelled.load(std::memory_order_relaxed);
+}
+
+// 多目标导出：每批行数与每个目标最多排队的批数
+const int kSinkBatchSize = 512;
+const int kSinkQueueCapacity = 8;
+
+using ExportBatch = std::shared_ptr<const QVector<ExportRow>>;
+
+// 有界批次队列：一个读取线程写入，一个目标线程读出。
+// 队列满时读取方等待；目标放弃后写入直接丢弃，读取方不会被卡住
+class BatchQueue
+{
+public:
+    void push(const ExportBatch& batch)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_batches.size() >= kSinkQueueCapacity && !m_abandoned) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (!m_abandoned) {
+            m_batches.enqueue(batch);
+            m_notEmpty.wakeOne();
+        }
+    }
+
+    // 返回空指针表示没有更多数据
+    ExportBatch pop()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_batches.isEmpty() && !m_finished) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_batches.isEmpty()) {
+            return ExportBatch();
+        }
+        ExportBatch batch = m_batches.dequeue();
+        m_notFull.wakeOne();
+        return batch;
+    }
+
+    void finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finished = true;
+        m_notEmpty.wakeOne();
+    }
+
+    void abandon()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_abandoned = true;
+        m_batches.clear();
+        m_notFull.wakeOne();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<ExportBatch> m_batches;
+    bool m_finished = false;
+    bool m_abandoned = false;
+};
+
+// 列 0-7 为任务字段；增量查询（changeColumns）额外带变更序号（8）和是否已删除（9）
+ExportRow readExportRow(const QSqlQuery& query, bool changeColumns)
+{
+    ExportRow row;
+    if (changeColumns) {
+        row.changeSeq = query.value(8).toLongLong();
+        row.change = query.value(9).toBool() ? ExportRow::DeletedRow : ExportRow::ChangedRow;
+    }
+    row.id = query.value(0).toInt();
+    row.title = query.value(1).toString();
+    row.description = query.value(2).toString();
+    row.categoryName = query.value(3).toString();
+    row.priority = static_cast<TaskPriority>(qBound(int(Low), query.value(4).toInt(), int(High)));
+    row.deadline = query.value(5).toDateTime();
+    row.completed = query.value(6).toBool();
+    row.createTime = query.value(7).toDateTime();
+    return row;
+}
+}
 
 ExportManager::ExportManager(QObject *parent)
     : QObject(parent)
@@ -18,7 +139,7 @@ ExportManager::ExportManager(QObject *parent)
     // Qt6 无需编码设置，删除 QTextCodec 相关逻辑
 }
 
-bool ExportManager::exportToExcel(const QString& filePath)
+bool ExportManager::exportToExcel(const QString& filePath, ExportProgress* progress)
 {
     // 数据库实例检查
     TaskDatabase* db = TaskDatabase::getInstance();
@@ -26,102 +147,159 @@ bool ExportManager::exportToExcel(const QString& filePath)
         qCritical() << "Excel导出失败：数据库实例为空";
         return false;
     }
-    QList<Task> tasks = db->getAllTasks();
-    QList<Category> categories = db->getAllCategories();
 
-    //分类映射构建
-    QMap<int, QString> categoryMap;
-    for (const Category& cat : categories) {
-        categoryMap[cat.id] = cat.name;
+    // 路径检查
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.dir().exists()) {
+        if (!QDir().mkpath(fileInfo.dir().path())) {
+            qCritical() << "Excel导出失败：无法创建目录" << fileInfo.dir().path();
+            return false;
+        }
+    }
+
+    // 逐行读取数据库并直接写入压缩流，不在内存中保留整张表
+    QSqlDatabase connection = db->getDatabaseConnection();
+    ReadSnapshot snapshot(connection);
+    QSqlQuery query(connection);
+    query.setForwardOnly(true);
+    if (!query.exec(R"(
+        SELECT t.id, t.title, t.description, IFNULL(c.name, '未分类'), t.priority, t.deadline, t.completed, t.create_time
+        FROM tasks t LEFT JOIN categories c ON c.id = t.category_id
+        ORDER BY t.deadline
+    )")) {
+        qCritical() << "Excel导出失败：" << query.lastError().text();
+        return false;
     }
 
-    //Excel 写入核心逻辑
-    QXlsx::Document xlsx;
+    XlsxStreamWriter xlsx(filePath);
+    if (!xlsx.open()) {
+        qCritical() << "Excel导出失败：" << xlsx.errorString();
+        return false;
+    }
 
     // 填充任务列表
-    xlsx.addSheet("任务列表");
-    xlsx.selectSheet("任务列表");
+    xlsx.beginSheet("任务列表");
 
     //表头
-    QStringList taskHeaders = {"ID", "任务标题", "描述", "分类", "优先级", "截止时间", "完成状态", "创建时间"};
-    for (int col = 0; col < taskHeaders.size(); col++) {
-        xlsx.write(1, col + 1, taskHeaders[col]); // 第1行是表头
+    const QStringList taskHeaders = {"ID", "任务标题", "描述", "分类", "优先级", "截止时间", "完成状态", "创建时间"};
+    xlsx.beginRow();
+    for (const QString& header : taskHeaders) {
+        xlsx.addString(header);
     }
+    xlsx.endRow();
 
     // 任务数据
-    for (int row = 0; row < tasks.size(); row++) {
-        const Task& task = tasks[row];
-        QString categoryName = categoryMap.value(task.categoryId, "未分类");
-        QString priorityText = (task.priority == Low) ? "低" : (task.priority == Medium) ? "中" : "高";
-        QString completedText = task.isCompleted ? "已完成" : "未完成";
-        int excelRow = row + 2; // 从第2行开始数据
-
-        xlsx.write(excelRow, 1, task.id);
-        xlsx.write(excelRow, 2, task.title);
-        xlsx.write(excelRow, 3, task.description);
-        xlsx.write(excelRow, 4, categoryName);
-        xlsx.write(excelRow, 5, priorityText);
-        xlsx.write(excelRow, 6, task.deadline);
-        xlsx.write(excelRow, 7, completedText);
-        xlsx.write(excelRow, 8, task.createTime);
+    const QString priorityTexts[] = {"低", "中", "高"};
+    const QString completedText = "已完成";
+    const QString pendingText = "未完成";
+    qint64 rows = 0;
+    while (query.next()) {
+        if (++rows % kProgressInterval == 0 && progress) {
+            if (isCancelled(progress)) {
+                xlsx.abort();
+                qInfo() << "Excel导出已取消：" << filePath;
+                return false;
+            }
+            progress->rows.store(rows, std::memory_order_relaxed);
+            progress->bytes.store(xlsx.bytesWritten(), std::memory_order_relaxed);
+        }
+
+        const int priority = query.value(4).toInt();
+        xlsx.beginRow();
+        xlsx.addNumber(query.value(0).toInt());
+        xlsx.addString(query.value(1).toString());
+        xlsx.addString(query.value(2).toString());
+        xlsx.addString(query.value(3).toString());
+        xlsx.addString(priorityTexts[qBound(int(Low), priority, int(High))]);
+        xlsx.addDateTime(query.value(5).toDateTime());
+        xlsx.addString(query.value(6).toBool() ? completedText : pendingText);
+        xlsx.addDateTime(query.value(7).toDateTime());
+        xlsx.endRow();
     }
+    query.finish();
 
     //填充统计报表
-    xlsx.addSheet("统计报表");
-    xlsx.selectSheet("统计报表");
+    xlsx.beginSheet("统计报表");
 
     // 统计报表内容
-    xlsx.write(1, 1, "个人任务管理统计报表");
-    xlsx.write(2, 1, "统计时间：");
-    xlsx.write(2, 2, QDateTime::currentDateTime());
+    xlsx.beginRow();
+    xlsx.addString("个人任务管理统计报表");
+    xlsx.endRow();
+    xlsx.beginRow();
+    xlsx.addString("统计时间：");
+    xlsx.addDateTime(QDateTime::currentDateTime());
+    xlsx.endRow();
+    xlsx.beginRow();
+    xlsx.endRow();
 
     // 添加更多统计信息
-    xlsx.write(4, 1, "总任务数：");
-    xlsx.write(4, 2, db->getTotalTaskCount());
-    xlsx.write(5, 1, "已完成任务数：");
-    xlsx.write(5, 2, db->getCompletedTaskCount());
-    xlsx.write(6, 1, "待完成任务数：");
-    xlsx.write(6, 2, db->getPendingTaskCount());
+    auto writeStat = [&xlsx](const QString& label, int value) {
+        xlsx.beginRow();
+        xlsx.addString(label);
+        xlsx.addNumber(value);
+        xlsx.endRow();
+    };
+    writeStat("总任务数：", db->getTotalTaskCount());
+    writeStat("已完成任务数：", db->getCompletedTaskCount());
+    writeStat("待完成任务数：", db->getPendingTaskCount());
+    xlsx.beginRow();
+    xlsx.endRow();
 
     // 按分类统计
-    xlsx.write(8, 1, "按分类统计：");
+    xlsx.beginRow();
+    xlsx.addString("按分类统计：");
+    xlsx.endRow();
     QMap<QString, int> catCount = db->getTaskCountByCategory();
-    int catRow = 9;
-    for (auto it = catCount.begin(); it != catCount.end(); ++it, ++catRow) {
-        xlsx.write(catRow, 1, it.key());
-        xlsx.write(catRow, 2, it.value());
+    for (auto it = catCount.begin(); it != catCount.end(); ++it) {
+        writeStat(it.key(), it.value());
     }
+    xlsx.beginRow();
+    xlsx.endRow();
 
     // 按优先级统计
-    xlsx.write(catRow + 2, 1, "按优先级统计：");
+    xlsx.beginRow();
+    xlsx.addString("按优先级统计：");
+    xlsx.endRow();
     QMap<TaskPriority, int> priCount = db->getTaskCountByPriority();
-    xlsx.write(catRow + 3, 1, "低优先级：");
-    xlsx.write(catRow + 3, 2, priCount[Low]);
-    xlsx.write(catRow + 4, 1, "中优先级：");
-    xlsx.write(catRow + 4, 2, priCount[Medium]);
-    xlsx.write(catRow + 5, 1, "高优先级：");
-    xlsx.write(catRow + 5, 2, priCount[High]);
-
-    // 4. 路径检查与保存
-    QFileInfo fileInfo(filePath);
-    if (!fileInfo.dir().exists()) {
-        if (!QDir().mkpath(fileInfo.dir().path())) {
-            qCritical() << "Excel导出失败：无法创建目录" << fileInfo.dir().path();
-            return false;
-        }
-    }
+    writeStat("低优先级：", priCount[Low]);
+    writeStat("中优先级：", priCount[Medium]);
+    writeStat("高优先级：", priCount[High]);
 
-    if (!xlsx.saveAs(filePath)) {
-        qCritical() << "Excel导出失败：" << filePath;
+    if (!xlsx.close()) {
+        qCritical() << "Excel导出失败：" << filePath << xlsx.errorString();
         return false;
     }
+    if (progress) {
+        progress->rows.store(rows, std::memory_order_relaxed);
+        progress->bytes.store(QFileInfo(filePath).size(), std::memory_order_relaxed);
+    }
 
     qInfo() << "Excel导出成功：" << filePath;
     return true;
 }
 
-bool ExportManager::exportToPdf(const QString& filePath)
+bool ExportManager::exportToPdf(const QString& filePath, ExportProgress* progress)
 {
+    TaskDatabase* db = TaskDatabase::getInstance();
+    if (!db) {
+        qCritical() << "PDF导出失败：数据库实例为空";
+        return false;
+    }
+
+    // 报表内容在同一个读快照内生成，任务逐行读取并直接绘制
+    QSqlDatabase connection = db->getDatabaseConnection();
+    ReadSnapshot snapshot(connection);
+    QSqlQuery query(connection);
+    query.setForwardOnly(true);
+    if (!query.exec(R"(
+        SELECT t.id, t.title, IFNULL(c.name, '未分类'), t.priority, t.deadline, t.completed
+        FROM tasks t LEFT JOIN categories c ON c.id = t.category_id
+        ORDER BY t.deadline
+    )")) {
+        qCritical() << "PDF导出失败：" << query.lastError().text();
+        return false;
+    }
+
     QPrinter printer(QPrinter::HighResolution);
     printer.setOutputFormat(QPrinter::PdfFormat);
     printer.setOutputFileName(filePath);
@@ -133,103 +311,272 @@ bool ExportManager::exportToPdf(const QString& filePath)
     QMarginsF margins(20, 20, 20, 20);
     printer.setPageMargins(margins, QPageLayout::Millimeter);
 
-    QTextDocument doc;
-    doc.setHtml(generateStatText());
-    doc.print(&printer);
+    PdfReportRenderer report(&printer);
+    if (!report.begin()) {
+        qCritical() << "PDF导出失败：无法写入文件" << filePath;
+        return false;
+    }
+
+    report.drawTitle("个人任务管理统计报表", "统计时间：" + QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm"));
+
+    report.drawHeading("一、统计概览");
+    report.beginTable({"统计项", "数值"}, {1, 1});
+    report.addRow({"总任务数", QString::number(db->getTotalTaskCount())});
+    report.addRow({"已完成任务数", QString::number(db->getCompletedTaskCount())});
+    report.addRow({"待完成任务数", QString::number(db->getPendingTaskCount())});
+    report.endTable();
+
+    // 按分类统计
+    report.drawHeading("二、按分类统计");
+    report.beginTable({"分类名称", "任务数"}, {1, 1});
+    QMap<QString, int> catCount = db->getTaskCountByCategory();
+    for (auto it = catCount.begin(); it != catCount.end(); ++it) {
+        report.addRow({it.key(), QString::number(it.value())});
+    }
+    report.endTable();
+
+    // 按优先级统计
+    report.drawHeading("三、按优先级统计");
+    report.beginTable({"优先级", "任务数"}, {1, 1});
+    QMap<TaskPriority, int> priCount = db->getTaskCountByPriority();
+    report.addRow({"低优先级", QString::number(priCount[Low])});
+    report.addRow({"中优先级", QString::number(priCount[Medium])});
+    report.addRow({"高优先级", QString::number(priCount[High])});
+    report.endTable();
+
+    // 任务列表：一行行画到页面上，不在内存中保留整张表
+    report.drawHeading("四、任务列表");
+    report.beginTable({"ID", "任务标题", "分类", "优先级", "截止时间", "完成状态"}, {0.7, 3, 1.2, 0.8, 1.8, 1});
+
+    const QString priorityTexts[] = {"低", "中", "高"};
+    const QString completedText = "已完成";
+    const QString pendingText = "未完成";
+    QStringList cells;
+    for (int i = 0; i < 6; ++i) {
+        cells.append(QString());
+    }
+    qint64 rows = 0;
+    while (query.next()) {
+        if (++rows % kProgressInterval == 0 && progress) {
+            if (isCancelled(progress)) {
+                report.abort();
+                qInfo() << "PDF导出已取消：" << filePath;
+                return false;
+            }
+            progress->rows.store(rows, std::memory_order_relaxed);
+        }
 
-    qInfo() << "PDF导出成功：" << filePath;
+        const bool completed = query.value(5).toBool();
+        cells[0] = query.value(0).toString();
+        cells[1] = query.value(1).toString();
+        cells[2] = query.value(2).toString();
+        cells[3] = priorityTexts[qBound(int(Low), query.value(3).toInt(), int(High))];
+        cells[4] = query.value(4).toDateTime().toString("yyyy-MM-dd HH:mm");
+        cells[5] = completed ? completedText : pendingText;
+        report.addRow(cells, completed);
+    }
+    query.finish();
+
+    if (!report.end()) {
+        qCritical() << "PDF导出失败：" << filePath;
+        return false;
+    }
+
+    if (progress) {
+        progress->rows.store(rows, std::memory_order_relaxed);
+        progress->bytes.store(QFileInfo(filePath).size(), std::memory_order_relaxed);
+    }
+
+    qInfo() << "PDF导出成功：" << filePath << "共" << report.pageCount() << "页";
     return true;
 }
 
-QString ExportManager::generateStatText()
+bool ExportManager::exportToSinks(const QVector<ExportSink*>& sinks, ExportProgress* progress)
 {
     TaskDatabase* db = TaskDatabase::getInstance();
-    QList<Task> tasks = db->getAllTasks();
-    QList<Category> categories = db->getAllCategories();
-
-    // 构建HTML内容
-    QString html = R"(
-        <html>
-        <head>
-            <meta charset="UTF-8">
-            <title>个人任务管理统计报表</title>
-            <style>
-                table { border-collapse: collapse; width: 100%; margin: 10px 0; }
-                th, td { border: 1px solid #000; padding: 8px; text-align: left; }
-                th { background-color: #f0f0f0; }
-                h1, h2 { text-align: center; }
-                .completed { color: #808080; }
-            </style>
-        </head>
-        <body>
-            <h1>个人任务管理统计报表</h1>
-            <p align="right">统计时间：)" + QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm") + R"(</p>
-
-            <h2>一、统计概览</h2>
-            <table>
-                <tr><th>统计项</th><th>数值</th></tr>
-                <tr><td>总任务数</td><td>)" + QString::number(db->getTotalTaskCount()) + R"(</td></tr>
-                <tr><td>已完成任务数</td><td>)" + QString::number(db->getCompletedTaskCount()) + R"(</td></tr>
-                <tr><td>待完成任务数</td><td>)" + QString::number(db->getPendingTaskCount()) + R"(</td></tr>
-            </table>
-
-            <h2>二、按分类统计</h2>
-            <table>
-                <tr><th>分类名称</th><th>任务数</th></tr>
-    )";
+    if (!db || sinks.isEmpty()) {
+        return false;
+    }
 
-    // 按分类统计
-    QMap<QString, int> catCount = db->getTaskCountByCategory();
-    for (auto it = catCount.begin(); it != catCount.end(); it++) {
-        html += "<tr><td>" + it.key() + "</td><td>" + QString::number(it.value()) + "</td></tr>";
+    QSqlDatabase connection = db->getDatabaseConnection();
+    ReadSnapshot snapshot(connection);
+    QSqlQuery query(connection);
+    query.setForwardOnly(true);
+    if (!query.exec(R"(
+        SELECT t.id, t.title, t.description, IFNULL(c.name, '未分类'), t.priority, t.deadline, t.completed, t.create_time
+        FROM tasks t LEFT JOIN categories c ON c.id = t.category_id
+        ORDER BY t.deadline
+    )")) {
+        qCritical() << "多格式导出失败：" << query.lastError().text();
+        return false;
     }
 
-    // 按优先级统计
-    html += R"(
-            </table>
-            <h2>三、按优先级统计</h2>
-            <table>
-                <tr><th>优先级</th><th>任务数</th></tr>
-                <tr><td>低优先级</td><td>)" + QString::number(db->getTaskCountByPriority()[Low]) + R"(</td></tr>
-                <tr><td>中优先级</td><td>)" + QString::number(db->getTaskCountByPriority()[Medium]) + R"(</td></tr>
-                <tr><td>高优先级</td><td>)" + QString::number(db->getTaskCountByPriority()[High]) + R"(</td></tr>
-            </table>
-
-            <h2>四、任务列表</h2>
-            <table>
-                <tr>
-                    <th>ID</th><th>任务标题</th><th>分类</th><th>优先级</th><th>截止时间</th><th>完成状态</th>
-                </tr>
-    )";
-
-    // 任务列表
-    for (const Task& task : tasks) {
-        QString categoryName = "未分类";
-        for (const Category& cat : categories) {
-            if (cat.id == task.categoryId) {
-                categoryName = cat.name;
+    return runSinkPipeline(query, sinks, progress);
+}
+
+bool ExportManager::exportChangesToSinks(const QVector<ExportSink*>& sinks, qint64 sinceSeq, qint64* highWaterMark,
+                                         ExportProgress* progress)
+{
+    TaskDatabase* db = TaskDatabase::getInstance();
+    if (!db || sinks.isEmpty()) {
+        return false;
+    }
+
+    // 高水位与变更行在同一个快照内读取，导出期间的新变更留给下一次
+    QSqlDatabase connection = db->getDatabaseConnection();
+    ReadSnapshot snapshot(connection);
+    const qint64 upToSeq = db->getLatestChangeSeq();
+    if (highWaterMark) {
+        *highWaterMark = upToSeq;
+    }
+
+    QSqlQuery query(connection);
+    query.setForwardOnly(true);
+    if (sinceSeq < 0) {
+        query.prepare(R"(
+            SELECT t.id, t.title, t.description, IFNULL(c.name, '未分类'), t.priority, t.deadline, t.completed, t.create_time
+            FROM tasks t LEFT JOIN categories c ON c.id = t.category_id
+            ORDER BY t.id
+        )");
+    } else {
+        // seq 为主键，范围扫描只触及区间内的变更；同一任务多次变更只输出一次
+        query.prepare(R"(
+            SELECT ch.task_id, t.title, t.description, IFNULL(c.name, '未分类'), t.priority, t.deadline, t.completed,
+                   t.create_time, ch.seq, t.id IS NULL
+            FROM (SELECT task_id, MAX(seq) AS seq FROM task_changes
+                  WHERE seq > :since AND seq <= :upTo GROUP BY task_id) ch
+            LEFT JOIN tasks t ON t.id = ch.task_id
+            LEFT JOIN categories c ON c.id = t.category_id
+            ORDER BY ch.seq
+        )");
+        query.bindValue(":since", sinceSeq);
+        query.bindValue(":upTo", upToSeq);
+    }
+    if (!query.exec()) {
+        qCritical() << "增量导出失败：" << query.lastError().text();
+        return false;
+    }
+
+    return runSinkPipeline(query, sinks, progress);
+}
+
+bool ExportManager::exportChangesToSinks(const QString& consumer, const QVector<ExportSink*>& sinks,
+                                         ExportProgress* progress)
+{
+    TaskDatabase* db = TaskDatabase::getInstance();
+    const qint64 sinceSeq = db->getExportWatermark(consumer);
+    qint64 highWaterMark = 0;
+    if (!exportChangesToSinks(sinks, sinceSeq, &highWaterMark, progress)) {
+        return false;
+    }
+
+    // 读快照已结束，再记录新的高水位
+    if (!db->setExportWatermark(consumer, highWaterMark)) {
+        return false;
+    }
+    // 所有导出方都已导出的变更不再需要；清理失败不影响本次导出结果
+    db->pruneExportedChanges();
+    qInfo() << "增量导出完成：" << consumer << "序号" << sinceSeq << "→" << highWaterMark;
+    return true;
+}
+
+bool ExportManager::runSinkPipeline(QSqlQuery& query, const QVector<ExportSink*>& sinks, ExportProgress* progress)
+{
+    // 是否为增量查询按结果列数只判断一次；目标在打开前得知，表头才能带上变更列
+    const bool changeColumns = query.record().count() > 8;
+
+    // 每个目标一个线程、一个队列；批次只读共享，不按目标复制
+    std::atomic_bool cancelled(false);
+    QVector<std::shared_ptr<BatchQueue>> queues;
+    QVector<std::shared_ptr<std::atomic_bool>> results;
+    QVector<QThread*> threads;
+    for (ExportSink* sink : sinks) {
+        auto queue = std::make_shared<BatchQueue>();
+        auto result = std::make_shared<std::atomic_bool>(false);
+        sink->setChangeColumns(changeColumns);
+        QThread* thread = QThread::create([sink, queue, result, &cancelled]() {
+            if (!sink->open()) {
+                queue->abandon();
+                sink->abort();
+                return;
+            }
+            while (ExportBatch batch = queue->pop()) {
+                if (!sink->writeRows(*batch)) {
+                    queue->abandon();
+                    sink->abort();
+                    return;
+                }
+            }
+            if (cancelled.load()) {
+                sink->abort();
+                return;
+            }
+            result->store(sink->close());
+        });
+        queues.append(queue);
+        results.append(result);
+        threads.append(thread);
+        thread->start();
+    }
+
+    // 读取一次，按批分发给所有目标
+    qint64 rows = 0;
+    auto batch = std::make_shared<QVector<ExportRow>>();
+    batch->reserve(kSinkBatchSize);
+    auto dispatch = [&]() {
+        ExportBatch shared = std::move(batch);
+        for (const auto& queue : queues) {
+            queue->push(shared);
+        }
+        batch = std::make_shared<QVector<ExportRow>>();
+        batch->reserve(kSinkBatchSize);
+    };
+    while (query.next()) {
+        batch->append(readExportRow(query, changeColumns));
+        if (batch->size() == kSinkBatchSize) {
+            dispatch();
+            rows += kSinkBatchSize;
+            if (progress) {
+                progress->rows.store(rows, std::memory_order_relaxed);
+            }
+            if (isCancelled(progress)) {
+                cancelled.store(true);
                 break;
             }
         }
-        QString priorityText = (task.priority == Low) ? "低" : (task.priority == Medium) ? "中" : "高";
-        QString completedText = task.isCompleted ? "已完成" : "未完成";
-        QString rowClass = task.isCompleted ? "class='completed'" : "";
-
-        html += "<tr " + rowClass + ">"
-                                    "<td>" + QString::number(task.id) + "</td>"
-                                             "<td>" + task.title + "</td>"
-                               "<td>" + categoryName + "</td>"
-                                 "<td>" + priorityText + "</td>"
-                                 "<td>" + task.deadline.toString("yyyy-MM-dd HH:mm") + "</td>"
-                                                               "<td>" + completedText + "</td>"
-                                  "</tr>";
-    }
-
-    html += R"(
-            </table>
-        </body>
-        </html>
-    )";
-
-    return html;
+    }
+    if (!cancelled.load() && !batch->isEmpty()) {
+        rows += batch->size();
+        dispatch();
+    }
+    query.finish();
+
+    for (const auto& queue : queues) {
+        queue->finish();
+    }
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    bool success = !cancelled.load();
+    qint64 bytes = 0;
+    for (int i = 0; i < sinks.size(); ++i) {
+        bytes += sinks[i]->bytesWritten();
+        if (!cancelled.load() && !results[i]->load()) {
+            qCritical() << "多格式导出失败：" << sinks[i]->errorString();
+            success = false;
+        }
+    }
+    if (progress) {
+        progress->rows.store(rows, std::memory_order_relaxed);
+        progress->bytes.store(bytes, std::memory_order_relaxed);
+    }
+
+    if (cancelled.load()) {
+        qInfo() << "多格式导出已取消";
+    } else if (success) {
+        qInfo() << "多格式导出成功：" << sinks.size() << "个目标，" << rows << "行";
+    }
+    return success;
 }
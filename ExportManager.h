@@ -3,11 +3,60 @@
 
 #include <QObject>
 #include <QString>
+#include <QVector>
 #include "TaskDatabase.h"
+#include <atomic>
 
-// 删除重复的头文件包含
-#include <xlsxdocument.h>
-#include <xlsxworksheet.h>
+// 导出进度：工作线程写入，界面线程定时读取；置 cancelled 后导出在下一行处停止
+struct ExportProgress {
+    std::atomic<qint64> rows{0};
+    std::atomic<qint64> bytes{0};
+    std::atomic_bool cancelled{false};
+};
+
+// 导出行：数据库读取一次，所有导出目标共享
+struct ExportRow {
+    // 全量导出均为 FullRow；增量导出区分变更与删除（删除行只有 id 有效）
+    enum Change {
+        FullRow,
+        ChangedRow,
+        DeletedRow
+    };
+
+    Change change = FullRow;
+    qint64 changeSeq = 0;
+    int id = 0;
+    QString title;
+    QString description;
+    QString categoryName;
+    TaskPriority priority = Low;
+    QDateTime deadline;
+    bool completed = false;
+    QDateTime createTime;
+};
+
+// 导出目标：每个目标在自己的线程中按顺序收到全部行。
+// open/writeRows/close 都在该线程中调用；失败后不会再收到数据
+class ExportSink
+{
+public:
+    virtual ~ExportSink() = default;
+
+    virtual bool open() = 0;
+    virtual bool writeRows(const QVector<ExportRow>& rows) = 0;
+    virtual bool close() = 0;
+    // 导出取消时调用，应删除未完成的输出
+    virtual void abort() = 0;
+
+    virtual QString errorString() const = 0;
+    virtual qint64 bytesWritten() const = 0;
+
+    // 增量导出时在 open() 之前调用：表格类目标据此在表头和每行的 ID 之后加上操作类型（op）与变更序号（seq）列
+    void setChangeColumns(bool enabled) { m_changeColumns = enabled; }
+
+protected:
+    bool m_changeColumns = false;
+};
 
 class ExportManager : public QObject
 {
@@ -15,11 +64,24 @@ class ExportManager : public QObject
 public:
     explicit ExportManager(QObject *parent = nullptr);
 
-    bool exportToExcel(const QString& filePath);
-    bool exportToPdf(const QString& filePath);
+    // 可在工作线程中调用；progress 为空时不汇报进度、不可取消
+    bool exportToExcel(const QString& filePath, ExportProgress* progress = nullptr);
+    bool exportToPdf(const QString& filePath, ExportProgress* progress = nullptr);
+
+    // 一次数据库扫描同时写出多种格式：每个目标一个线程，经有界队列分发，
+    // 慢的目标只会让读取等待，不会让内存无限增长。任一目标失败则返回 false
+    bool exportToSinks(const QVector<ExportSink*>& sinks, ExportProgress* progress = nullptr);
+
+    // 增量导出：只输出变更序号在 (sinceSeq, *highWaterMark] 之间有变化的任务，每个任务一行（取最后状态）。
+    // 导出开始时读取当前最大序号写入 highWaterMark；sinceSeq < 0 时输出全部任务
+    bool exportChangesToSinks(const QVector<ExportSink*>& sinks, qint64 sinceSeq, qint64* highWaterMark,
+                              ExportProgress* progress = nullptr);
+    // 按导出方名称读取上次的高水位，导出成功后记录新的高水位并清理所有导出方都已导出的变更；首次导出为全量
+    bool exportChangesToSinks(const QString& consumer, const QVector<ExportSink*>& sinks,
+                              ExportProgress* progress = nullptr);
 
 private:
-    QString generateStatText();
+    bool runSinkPipeline(QSqlQuery& query, const QVector<ExportSink*>& sinks, ExportProgress* progress);
 };
 
 #endif // EXPORTMANAGER_H
@@ -0,0 +1,302 @@
+#include "ExportSinks.h"
+#include "XlsxStreamWriter.h"
+
+namespace {
+const int kFlushSize = 64 * 1024;
+
+QString priorityText(TaskPriority priority)
+{
+    return (priority == Low) ? "低" : (priority == Medium) ? "中" : "高";
+}
+
+// 增量导出的操作类型，各格式一致
+const char* changeOperation(ExportRow::Change change)
+{
+    return change == ExportRow::DeletedRow ? "delete" : "upsert";
+}
+}
+
+TextFileExportSink::TextFileExportSink(const QString& filePath)
+    : m_file(filePath)
+{
+}
+
+bool TextFileExportSink::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = "无法打开文件：" + m_file.fileName() + " " + m_file.errorString();
+        return false;
+    }
+    m_created = true;
+    m_buffer.reserve(kFlushSize + 4096);
+    writeHeader();
+    return flush(false);
+}
+
+bool TextFileExportSink::close()
+{
+    bool success = flush(true);
+    m_file.close();
+    return success;
+}
+
+void TextFileExportSink::abort()
+{
+    m_buffer.clear();
+    m_file.close();
+    // 打开失败时文件不是本目标创建的（可能是已有文件），不能删除
+    if (m_created) {
+        m_file.remove();
+    }
+}
+
+bool TextFileExportSink::flush(bool force)
+{
+    if (m_buffer.isEmpty() || (!force && m_buffer.size() < kFlushSize)) {
+        return true;
+    }
+    if (m_file.write(m_buffer) != m_buffer.size()) {
+        m_errorString = "写入文件失败：" + m_file.fileName() + " " + m_file.errorString();
+        return false;
+    }
+    m_bytesWritten += m_buffer.size();
+    m_buffer.clear();
+    return true;
+}
+
+CsvExportSink::CsvExportSink(const QString& filePath)
+    : TextFileExportSink(filePath)
+{
+}
+
+void CsvExportSink::writeHeader()
+{
+    m_buffer += "\xEF\xBB\xBF";
+    m_buffer += m_changeColumns ? "ID,op,seq," : "ID,";
+    m_buffer += QString("任务标题,描述,分类,优先级,截止时间,完成状态,创建时间\r\n").toUtf8();
+}
+
+bool CsvExportSink::writeRows(const QVector<ExportRow>& rows)
+{
+    for (const ExportRow& row : rows) {
+        m_buffer += QByteArray::number(row.id);
+        // 增量导出：ID 之后是操作类型和变更序号
+        if (m_changeColumns) {
+            m_buffer += ',';
+            if (row.change != ExportRow::FullRow) {
+                m_buffer += changeOperation(row.change);
+                m_buffer += ',';
+                m_buffer += QByteArray::number(row.changeSeq);
+            } else {
+                m_buffer += ',';
+            }
+        }
+        if (row.change == ExportRow::DeletedRow) {
+            m_buffer += QString(",,,,,,已删除,\r\n").toUtf8();
+            continue;
+        }
+        m_buffer += ',';
+        appendField(row.title);
+        m_buffer += ',';
+        appendField(row.description);
+        m_buffer += ',';
+        appendField(row.categoryName);
+        m_buffer += ',';
+        appendField(priorityText(row.priority));
+        m_buffer += ',';
+        appendField(row.deadline.toString("yyyy-MM-dd HH:mm"));
+        m_buffer += ',';
+        appendField(row.completed ? "已完成" : "未完成");
+        m_buffer += ',';
+        appendField(row.createTime.toString("yyyy-MM-dd HH:mm"));
+        m_buffer += "\r\n";
+        if (!flush(false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CsvExportSink::appendField(const QString& value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    // 含分隔符、引号或换行的字段整体加引号，内部引号写两次
+    bool quote = false;
+    for (char ch : utf8) {
+        if (ch == ',' || ch == '"' || ch == '\n' || ch == '\r') {
+            quote = true;
+            break;
+        }
+    }
+    if (!quote) {
+        m_buffer += utf8;
+        return;
+    }
+    m_buffer += '"';
+    for (char ch : utf8) {
+        if (ch == '"') {
+            m_buffer += '"';
+        }
+        m_buffer += ch;
+    }
+    m_buffer += '"';
+}
+
+JsonLinesExportSink::JsonLinesExportSink(const QString& filePath)
+    : TextFileExportSink(filePath)
+{
+}
+
+bool JsonLinesExportSink::writeRows(const QVector<ExportRow>& rows)
+{
+    for (const ExportRow& row : rows) {
+        m_buffer += "{\"id\":";
+        m_buffer += QByteArray::number(row.id);
+        // 增量导出带上操作类型和变更序号，删除行只有 id
+        if (row.change != ExportRow::FullRow) {
+            m_buffer += ",\"op\":\"";
+            m_buffer += changeOperation(row.change);
+            m_buffer += "\",\"seq\":";
+            m_buffer += QByteArray::number(row.changeSeq);
+            if (row.change == ExportRow::DeletedRow) {
+                m_buffer += "}\n";
+                continue;
+            }
+        }
+        m_buffer += ",\"title\":";
+        appendString(row.title);
+        m_buffer += ",\"description\":";
+        appendString(row.description);
+        m_buffer += ",\"category\":";
+        appendString(row.categoryName);
+        m_buffer += ",\"priority\":";
+        m_buffer += QByteArray::number(int(row.priority));
+        m_buffer += ",\"deadline\":";
+        appendDateTime(row.deadline);
+        m_buffer += ",\"completed\":";
+        m_buffer += row.completed ? "true" : "false";
+        m_buffer += ",\"createTime\":";
+        appendDateTime(row.createTime);
+        m_buffer += "}\n";
+        if (!flush(false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JsonLinesExportSink::appendString(const QString& value)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    const QByteArray utf8 = value.toUtf8();
+    m_buffer += '"';
+    for (char ch : utf8) {
+        switch (ch) {
+        case '"': m_buffer += "\\\""; break;
+        case '\\': m_buffer += "\\\\"; break;
+        case '\n': m_buffer += "\\n"; break;
+        case '\r': m_buffer += "\\r"; break;
+        case '\t': m_buffer += "\\t"; break;
+        default:
+            if (uchar(ch) < 0x20) {
+                m_buffer += "\\u00";
+                m_buffer += hexDigits[uchar(ch) >> 4];
+                m_buffer += hexDigits[uchar(ch) & 0x0f];
+            } else {
+                m_buffer += ch;
+            }
+        }
+    }
+    m_buffer += '"';
+}
+
+void JsonLinesExportSink::appendDateTime(const QDateTime& value)
+{
+    if (!value.isValid()) {
+        m_buffer += "null";
+        return;
+    }
+    m_buffer += '"';
+    m_buffer += value.toString(Qt::ISODate).toUtf8();
+    m_buffer += '"';
+}
+
+XlsxExportSink::XlsxExportSink(const QString& filePath)
+    : m_writer(new XlsxStreamWriter(filePath))
+{
+}
+
+XlsxExportSink::~XlsxExportSink() = default;
+
+bool XlsxExportSink::open()
+{
+    if (!m_writer->open() || !m_writer->beginSheet("任务列表")) {
+        return false;
+    }
+    QStringList headers = {"ID", "任务标题", "描述", "分类", "优先级", "截止时间", "完成状态", "创建时间"};
+    if (m_changeColumns) {
+        headers.insert(1, "op");
+        headers.insert(2, "seq");
+    }
+    m_writer->beginRow();
+    for (const QString& header : std::as_const(headers)) {
+        m_writer->addString(header);
+    }
+    m_writer->endRow();
+    return true;
+}
+
+bool XlsxExportSink::writeRows(const QVector<ExportRow>& rows)
+{
+    const QString completedText = "已完成";
+    const QString pendingText = "未完成";
+    const QString deletedText = "已删除";
+    for (const ExportRow& row : rows) {
+        m_writer->beginRow();
+        m_writer->addNumber(row.id);
+        // 增量导出：ID 之后是操作类型和变更序号
+        if (m_changeColumns) {
+            if (row.change != ExportRow::FullRow) {
+                m_writer->addString(QString::fromLatin1(changeOperation(row.change)));
+                m_writer->addNumber(row.changeSeq);
+            } else {
+                m_writer->addEmpty();
+                m_writer->addEmpty();
+            }
+        }
+        if (row.change == ExportRow::DeletedRow) {
+            for (int i = 0; i < 5; ++i) {
+                m_writer->addEmpty();
+            }
+            m_writer->addString(deletedText);
+            m_writer->endRow();
+            continue;
+        }
+        m_writer->addString(row.title);
+        m_writer->addString(row.description);
+        m_writer->addString(row.categoryName);
+        m_writer->addString(priorityText(row.priority));
+        m_writer->addDateTime(row.deadline);
+        m_writer->addString(row.completed ? completedText : pendingText);
+        m_writer->addDateTime(row.createTime);
+        m_writer->endRow();
+    }
+    return m_writer->errorString().isEmpty();
+}
+
+bool XlsxExportSink::close()
+{
+    bool success = m_writer->close();
+    m_bytesWritten = m_writer->bytesWritten();
+    return success;
+}
+
+void XlsxExportSink::abort()
+{
+    m_writer->abort();
+}
+
+QString XlsxExportSink::errorString() const
+{
+    return m_writer->errorString();
+}
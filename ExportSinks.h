@@ -0,0 +1,85 @@
+#ifndef EXPORTSINKS_H
+#define EXPORTSINKS_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <memory>
+#include "ExportManager.h"
+
+class XlsxStreamWriter;
+
+// 逐行写文本文件的导出目标公共部分：输出先攒在缓冲区，够大再写文件
+class TextFileExportSink : public ExportSink
+{
+public:
+    explicit TextFileExportSink(const QString& filePath);
+
+    bool open() override;
+    bool close() override;
+    void abort() override;
+
+    QString errorString() const override { return m_errorString; }
+    qint64 bytesWritten() const override { return m_bytesWritten; }
+
+protected:
+    // 文件打开后写入的开头内容（如表头）
+    virtual void writeHeader() {}
+    bool flush(bool force);
+
+    QByteArray m_buffer;
+
+private:
+    QFile m_file;
+    QString m_errorString;
+    qint64 m_bytesWritten = 0;
+    bool m_created = false; // open() 成功创建了文件
+};
+
+// CSV：UTF-8 带 BOM，方便 Excel 直接打开；字段按 RFC 4180 加引号
+class CsvExportSink : public TextFileExportSink
+{
+public:
+    explicit CsvExportSink(const QString& filePath);
+    bool writeRows(const QVector<ExportRow>& rows) override;
+
+protected:
+    void writeHeader() override;
+
+private:
+    void appendField(const QString& value);
+};
+
+// JSON Lines：每行一个任务对象，时间为 ISO 8601，空值为 null
+class JsonLinesExportSink : public TextFileExportSink
+{
+public:
+    explicit JsonLinesExportSink(const QString& filePath);
+    bool writeRows(const QVector<ExportRow>& rows) override;
+
+private:
+    void appendString(const QString& value);
+    void appendDateTime(const QDateTime& value);
+};
+
+// XLSX：通过 XlsxStreamWriter 流式写出任务列表工作表
+class XlsxExportSink : public ExportSink
+{
+public:
+    explicit XlsxExportSink(const QString& filePath);
+    ~XlsxExportSink() override;
+
+    bool open() override;
+    bool writeRows(const QVector<ExportRow>& rows) override;
+    bool close() override;
+    void abort() override;
+
+    QString errorString() const override;
+    qint64 bytesWritten() const override { return m_bytesWritten; }
+
+private:
+    std::unique_ptr<XlsxStreamWriter> m_writer;
+    qint64 m_bytesWritten = 0;
+};
+
+#endif // EXPORTSINKS_H
@@ -0,0 +1,216 @@
+#include "PdfReportRenderer.h"
+#include <QFile>
+#include <QPageLayout>
+#include <QPrinter>
+
+namespace {
+const int kMaxCachedTextLength = 16; // 只缓存短文本，标题等长文本逐行计算
+const int kMaxCachedTexts = 1024;    // 每列缓存上限
+}
+
+PdfReportRenderer::PdfReportRenderer(QPrinter* printer)
+    : m_printer(printer)
+{
+}
+
+bool PdfReportRenderer::begin()
+{
+    if (!m_painter.begin(m_printer)) {
+        return false;
+    }
+
+    // 坐标原点为可打印区域左上角，单位为设备像素
+    const QRectF paintRect = m_printer->pageLayout().paintRectPixels(m_printer->resolution());
+    m_pageWidth = paintRect.width();
+    m_pageHeight = paintRect.height();
+
+    m_titleFont.setPointSizeF(18);
+    m_titleFont.setBold(true);
+    m_headingFont.setPointSizeF(13);
+    m_headingFont.setBold(true);
+    m_bodyFont.setPointSizeF(9);
+    m_headerFont = m_bodyFont;
+    m_headerFont.setBold(true);
+
+    // 字体度量只计算一次，逐行绘制时直接使用
+    m_bodyMetrics.reset(new QFontMetricsF(m_bodyFont, m_printer));
+    m_bodyAscent = m_bodyMetrics->ascent();
+    m_padding = m_bodyMetrics->height() * 0.35;
+    m_rowHeight = m_bodyMetrics->height() + 2 * m_padding;
+    m_footerHeight = m_rowHeight * 1.5;
+    m_borderPen = QPen(Qt::black, m_printer->resolution() / 150.0);
+
+    m_pageNumber = 1;
+    m_y = 0;
+    return true;
+}
+
+bool PdfReportRenderer::end()
+{
+    if (m_inTable) {
+        endTable();
+    }
+    drawFooter();
+    return m_painter.end();
+}
+
+void PdfReportRenderer::abort()
+{
+    m_inTable = false;
+    if (m_painter.isActive()) {
+        m_painter.end();
+    }
+    QFile::remove(m_printer->outputFileName());
+}
+
+void PdfReportRenderer::drawTitle(const QString& title, const QString& subtitle)
+{
+    const qreal titleHeight = QFontMetricsF(m_titleFont, m_printer).height() * 1.6;
+    ensureSpace(titleHeight + m_rowHeight);
+
+    m_painter.setPen(Qt::black);
+    m_painter.setFont(m_titleFont);
+    m_painter.drawText(QRectF(0, m_y, m_pageWidth, titleHeight), Qt::AlignCenter, title);
+    m_y += titleHeight;
+
+    m_painter.setFont(m_bodyFont);
+    m_painter.drawText(QRectF(0, m_y, m_pageWidth, m_rowHeight), Qt::AlignRight | Qt::AlignVCenter, subtitle);
+    m_y += m_rowHeight;
+}
+
+void PdfReportRenderer::drawHeading(const QString& text)
+{
+    const qreal headingHeight = QFontMetricsF(m_headingFont, m_printer).height() * 1.8;
+    // 标题至少和表头、首行在同一页
+    ensureSpace(headingHeight + 2 * m_rowHeight);
+
+    m_painter.setPen(Qt::black);
+    m_painter.setFont(m_headingFont);
+    m_painter.drawText(QRectF(0, m_y, m_pageWidth, headingHeight), Qt::AlignCenter, text);
+    m_y += headingHeight;
+}
+
+void PdfReportRenderer::beginTable(const QStringList& headers, const QVector<qreal>& weights)
+{
+    qreal totalWeight = 0;
+    for (qreal weight : weights) {
+        totalWeight += weight;
+    }
+
+    // 列宽按权重分配，整张表只计算一次
+    m_headers = headers;
+    m_columns.clear();
+    qreal x = 0;
+    for (int i = 0; i < headers.size(); ++i) {
+        ColumnMetrics column;
+        column.x = x;
+        column.width = m_pageWidth * (i < weights.size() ? weights[i] : 1.0) / totalWeight;
+        column.textWidth = qMax<qreal>(0, column.width - 2 * m_padding);
+        m_columns.append(column);
+        x += column.width;
+    }
+    m_fittedTexts = QVector<QHash<QString, QString>>(m_columns.size());
+
+    m_inTable = true;
+    ensureSpace(2 * m_rowHeight);
+    drawTableHeader();
+}
+
+void PdfReportRenderer::addRow(const QStringList& cells, bool dimmed)
+{
+    ensureSpace(m_rowHeight);
+
+    m_painter.setFont(m_bodyFont);
+    m_painter.setPen(m_borderPen);
+    m_painter.setBrush(Qt::NoBrush);
+    for (const ColumnMetrics& column : m_columns) {
+        m_painter.drawRect(QRectF(column.x, m_y, column.width, m_rowHeight));
+    }
+
+    m_painter.setPen(dimmed ? QColor(0x80, 0x80, 0x80) : QColor(Qt::black));
+    for (int i = 0; i < m_columns.size() && i < cells.size(); ++i) {
+        drawCell(i, m_y, cells[i]);
+    }
+    m_y += m_rowHeight;
+}
+
+void PdfReportRenderer::endTable()
+{
+    m_inTable = false;
+    m_y += m_rowHeight / 2;
+}
+
+void PdfReportRenderer::ensureSpace(qreal height)
+{
+    if (m_y > 0 && m_y + height > m_pageHeight - m_footerHeight) {
+        newPage();
+    }
+}
+
+void PdfReportRenderer::newPage()
+{
+    drawFooter();
+    m_printer->newPage();
+    ++m_pageNumber;
+    m_y = 0;
+    if (m_inTable) {
+        drawTableHeader();
+    }
+}
+
+void PdfReportRenderer::drawFooter()
+{
+    m_painter.setPen(Qt::black);
+    m_painter.setFont(m_bodyFont);
+    m_painter.drawText(QRectF(0, m_pageHeight - m_rowHeight, m_pageWidth, m_rowHeight),
+                       Qt::AlignCenter, QString("第 %1 页").arg(m_pageNumber));
+}
+
+void PdfReportRenderer::drawTableHeader()
+{
+    m_painter.setFont(m_headerFont);
+    m_painter.setPen(m_borderPen);
+    m_painter.setBrush(QColor(0xf0, 0xf0, 0xf0));
+    for (const ColumnMetrics& column : m_columns) {
+        m_painter.drawRect(QRectF(column.x, m_y, column.width, m_rowHeight));
+    }
+    m_painter.setBrush(Qt::NoBrush);
+
+    m_painter.setPen(Qt::black);
+    for (int i = 0; i < m_columns.size() && i < m_headers.size(); ++i) {
+        const ColumnMetrics& column = m_columns[i];
+        m_painter.drawText(QRectF(column.x + m_padding, m_y, column.textWidth, m_rowHeight),
+                           Qt::AlignLeft | Qt::AlignVCenter, m_headers[i]);
+    }
+    m_y += m_rowHeight;
+}
+
+void PdfReportRenderer::drawCell(int column, qreal y, const QString& text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    m_painter.drawText(QPointF(m_columns[column].x + m_padding, y + m_padding + m_bodyAscent), fittedText(column, text));
+}
+
+QString PdfReportRenderer::fittedText(int column, const QString& text)
+{
+    // 单行显示，超出列宽的部分以省略号截断
+    if (text.size() > kMaxCachedTextLength) {
+        QString line = text;
+        line.replace('\n', ' ');
+        return m_bodyMetrics->elidedText(line, Qt::ElideRight, m_columns[column].textWidth);
+    }
+
+    QHash<QString, QString>& cache = m_fittedTexts[column];
+    auto it = cache.constFind(text);
+    if (it != cache.constEnd()) {
+        return it.value();
+    }
+    if (cache.size() >= kMaxCachedTexts) {
+        cache.clear();
+    }
+    QString line = text;
+    line.replace('\n', ' ');
+    return cache.insert(text, m_bodyMetrics->elidedText(line, Qt::ElideRight, m_columns[column].textWidth)).value();
+}
@@ -0,0 +1,77 @@
+#ifndef PDFREPORTRENDERER_H
+#define PDFREPORTRENDERER_H
+
+#include <QFont>
+#include <QFontMetricsF>
+#include <QHash>
+#include <QPainter>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class QPrinter;
+
+// PDF 报表直接绘制：用 QPainter 逐行把表格画到 QPrinter 页面上，写满一页即换页。
+// 列宽和字体度量在建表时算好，重复出现的短文本缓存截断结果；内存占用与行数无关。
+// 用法：begin() → drawTitle()/drawHeading() → beginTable() / addRow() … → end()
+class PdfReportRenderer
+{
+public:
+    explicit PdfReportRenderer(QPrinter* printer);
+
+    bool begin();
+    bool end();
+    // 放弃绘制：结束打印并删除未完成的文件
+    void abort();
+
+    void drawTitle(const QString& title, const QString& subtitle);
+    void drawHeading(const QString& text);
+
+    // weights 为各列相对宽度；表格跨页时每页重复表头
+    void beginTable(const QStringList& headers, const QVector<qreal>& weights);
+    void addRow(const QStringList& cells, bool dimmed = false);
+    void endTable();
+
+    int pageCount() const { return m_pageNumber; }
+
+private:
+    struct ColumnMetrics {
+        qreal x = 0;
+        qreal width = 0;
+        qreal textWidth = 0; // 去掉左右内边距后的可用宽度
+    };
+
+    void ensureSpace(qreal height);
+    void newPage();
+    void drawFooter();
+    void drawTableHeader();
+    void drawCell(int column, qreal y, const QString& text);
+    QString fittedText(int column, const QString& text);
+
+    QPrinter* m_printer;
+    QPainter m_painter;
+    qreal m_pageWidth = 0;
+    qreal m_pageHeight = 0;
+    qreal m_footerHeight = 0;
+    qreal m_y = 0;
+    int m_pageNumber = 0;
+
+    QFont m_titleFont;
+    QFont m_headingFont;
+    QFont m_bodyFont;
+    QFont m_headerFont;
+    qreal m_bodyAscent = 0;
+    qreal m_rowHeight = 0;
+    qreal m_padding = 0;
+    QPen m_borderPen;
+    std::unique_ptr<QFontMetricsF> m_bodyMetrics;
+
+    QStringList m_headers;
+    QVector<ColumnMetrics> m_columns;
+    bool m_inTable = false;
+
+    // 每列短文本（分类、优先级、状态等）的截断结果缓存；超过上限整体清空
+    QVector<QHash<QString, QString>> m_fittedTexts;
+};
+
+#endif // PDFREPORTRENDERER_H
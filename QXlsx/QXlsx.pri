@@ -5,6 +5,9 @@
 QT += core
 QT += gui-private
 
+# ZipWriter deflates package parts with zlib
+LIBS += -lz
+
 # TODO: Define your C++ version. c++14, c++17, etc.
 CONFIG += c++11
 
@@ -65,6 +68,7 @@ $${QXLSX_HEADERPATH}xlsxcelllocation.h \
 $${QXLSX_HEADERPATH}xlsxcellrange.h \
 $${QXLSX_HEADERPATH}xlsxcellreference.h \
 $${QXLSX_HEADERPATH}xlsxcell_p.h \
+$${QXLSX_HEADERPATH}xlsxcelltable_p.h \
 $${QXLSX_HEADERPATH}xlsxchart.h \
 $${QXLSX_HEADERPATH}xlsxchartsheet.h \
 $${QXLSX_HEADERPATH}xlsxchartsheet_p.h \
@@ -87,10 +91,12 @@ $${QXLSX_HEADERPATH}xlsxformat_p.h \
 $${QXLSX_HEADERPATH}xlsxglobal.h \
 $${QXLSX_HEADERPATH}xlsxmediafile_p.h \
 $${QXLSX_HEADERPATH}xlsxnumformatparser_p.h \
+$${QXLSX_HEADERPATH}xlsxparallel_p.h \
 $${QXLSX_HEADERPATH}xlsxrelationships_p.h \
 $${QXLSX_HEADERPATH}xlsxrichstring.h \
 $${QXLSX_HEADERPATH}xlsxrichstring_p.h \
 $${QXLSX_HEADERPATH}xlsxsharedstrings_p.h \
+$${QXLSX_HEADERPATH}xlsxsheetdatawriter_p.h \
 $${QXLSX_HEADERPATH}xlsxsimpleooxmlfile_p.h \
 $${QXLSX_HEADERPATH}xlsxstyles_p.h \
 $${QXLSX_HEADERPATH}xlsxtheme_p.h \
@@ -111,6 +117,7 @@ $${QXLSX_SOURCEPATH}xlsxcellformula.cpp \
 $${QXLSX_SOURCEPATH}xlsxcelllocation.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellrange.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellreference.cpp \
+$${QXLSX_SOURCEPATH}xlsxcelltable.cpp \
 $${QXLSX_SOURCEPATH}xlsxchart.cpp \
 $${QXLSX_SOURCEPATH}xlsxchartsheet.cpp \
 $${QXLSX_SOURCEPATH}xlsxcolor.cpp \
@@ -126,9 +133,11 @@ $${QXLSX_SOURCEPATH}xlsxdrawinganchor.cpp \
 $${QXLSX_SOURCEPATH}xlsxformat.cpp \
 $${QXLSX_SOURCEPATH}xlsxmediafile.cpp \
 $${QXLSX_SOURCEPATH}xlsxnumformatparser.cpp \
+$${QXLSX_SOURCEPATH}xlsxparallel.cpp \
 $${QXLSX_SOURCEPATH}xlsxrelationships.cpp \
 $${QXLSX_SOURCEPATH}xlsxrichstring.cpp \
 $${QXLSX_SOURCEPATH}xlsxsharedstrings.cpp \
+$${QXLSX_SOURCEPATH}xlsxsheetdatawriter.cpp \
 $${QXLSX_SOURCEPATH}xlsxsimpleooxmlfile.cpp \
 $${QXLSX_SOURCEPATH}xlsxstyles.cpp \
 $${QXLSX_SOURCEPATH}xlsxtheme.cpp \
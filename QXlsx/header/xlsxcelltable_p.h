@@ -0,0 +1,165 @@
+// xlsxcelltable_p.h
+
+#ifndef XLSXCELLTABLE_P_H
+#define XLSXCELLTABLE_P_H
+
+#include "xlsxcell.h"
+#include "xlsxcellformula.h"
+#include "xlsxglobal.h"
+
+#include <vector>
+
+#include <QVariant>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  A worksheet cell packed into 16 bytes: the payload, the xf index of its
+  format and a Cell::CellType tag. Numbers, booleans and shared strings are
+  stored inline; formulas and text values live in the owning table's extra
+  list and the payload holds their index.
+ */
+struct CellData {
+    enum : quint8 { NullType = 0xff };
+    enum Flag : quint8 {
+        HasValue = 0x01, // number, date or custom cell that is not blank
+        HasExtra = 0x02, // payload is an index into CellTable's extras
+    };
+
+    CellData()
+        : number(0)
+    {
+    }
+
+    bool isNull() const { return type == NullType; }
+
+    union {
+        double number;
+        qint32 index; // shared string index or extra index
+        bool boolean;
+    };
+    qint32 style = -1;       // xf index, -1 if the cell has no format of its own
+    quint8 type  = NullType; // Cell::CellType
+    quint8 flags = 0;
+};
+
+struct CellExtra {
+    QVariant value;
+    CellFormula formula;
+};
+
+/*
+  Row-major chunked cell storage.
+
+  Rows are kept sorted inside row blocks of bounded size, and blocks are
+  sorted by their first row, so in-order iteration needs no sorting and
+  appending rows in ascending order is O(1). Each row holds its cells in a
+  dense column array starting at its first used column, and switches to a
+  sparse sorted column array once the dense one would be mostly holes.
+ */
+class CellTable
+{
+public:
+    class Row
+    {
+    public:
+        int row() const { return m_row; }
+        int cellCount() const { return m_count; }
+        int firstColumn() const { return m_dense ? m_firstColumn : m_columns.front(); }
+        int lastColumn() const
+        {
+            return m_dense ? m_firstColumn + int(m_cells.size()) - 1 : m_columns.back();
+        }
+
+        const CellData *cellAt(int column) const;
+
+        // Calls f(int column, const CellData &cell) for each cell in column order.
+        template <typename Function>
+        void forEach(Function f) const
+        {
+            if (m_dense) {
+                for (size_t i = 0; i < m_cells.size(); ++i) {
+                    if (!m_cells[i].isNull())
+                        f(m_firstColumn + int(i), m_cells[i]);
+                }
+            } else {
+                for (size_t i = 0; i < m_cells.size(); ++i)
+                    f(m_columns[i], m_cells[i]);
+            }
+        }
+
+    private:
+        friend class CellTable;
+
+        CellData setCell(int column, const CellData &cell);
+        void makeSparse();
+
+        int m_row         = 0;
+        int m_firstColumn = 0;
+        int m_count       = 0;
+        bool m_dense      = true;
+        std::vector<int> m_columns; // sparse rows only, parallel to m_cells
+        std::vector<CellData> m_cells;
+    };
+
+    void setValue(int row, int column, const CellData &cell);
+    // Stores \a count cells of \a row from \a column on; null cells are skipped.
+    void setCells(int row, int column, const CellData *cells, int count);
+    const CellData *cellAt(int row, int column) const;
+    bool contains(int row, int column) const { return cellAt(row, column) != nullptr; }
+    const Row *findRow(int row) const;
+
+    // The returned index stays valid until the cell using it is replaced.
+    qint32 addExtra(const QVariant &value, const CellFormula &formula);
+    const CellExtra &extraAt(qint32 index) const { return m_extras[size_t(index)]; }
+
+    bool isEmpty() const { return m_cellCount == 0; }
+    int cellCount() const { return m_cellCount; }
+    void clear();
+
+    // Calls f(const Row &row) for each non-empty row in row order.
+    template <typename Function>
+    void forEachRow(Function f) const
+    {
+        for (const Block &block : m_blocks) {
+            for (const Row &row : block.rows)
+                f(row);
+        }
+    }
+
+    // Calls f(int row, int column, const CellData &cell) in row-major order.
+    template <typename Function>
+    void forEachCell(Function f) const
+    {
+        for (const Block &block : m_blocks) {
+            for (const Row &row : block.rows) {
+                const int rowNumber = row.row();
+                row.forEach([&](int column, const CellData &cell) { f(rowNumber, column, cell); });
+            }
+        }
+    }
+
+    int firstRow    = -1;
+    int firstColumn = -1;
+    int lastRow     = -1;
+    int lastColumn  = -1;
+
+private:
+    struct Block {
+        std::vector<Row> rows;
+    };
+
+    Row &rowForWrite(int row);
+    void storeCell(Row &row, int column, const CellData &cell);
+    void extendBounds(int row, int first, int last);
+    std::vector<Block>::const_iterator findBlock(int row) const;
+    void releaseExtra(qint32 index);
+
+    std::vector<Block> m_blocks;
+    std::vector<CellExtra> m_extras;
+    std::vector<qint32> m_freeExtras;
+    int m_cellCount = 0;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCELLTABLE_P_H
@@ -114,6 +114,9 @@ public:
     AbstractSheet *currentSheet() const;
     Worksheet *currentWorksheet() const;
 
+    void setCompressionLevel(int level);
+    int compressionLevel() const;
+
     bool save() const;
     bool saveAs(const QString &xlsXname) const;
     bool saveAs(QIODevice *device) const;
@@ -37,6 +37,7 @@ public:
     std::shared_ptr<Workbook> workbook;
     std::shared_ptr<ContentTypes> contentTypes;
     bool isLoad;
+    int compressionLevel; // zlib level used by savePackage, -1 for the default
 
     // Store the entire xlsx (zip) bytes so that even when opened with QIODevice, the zip can be reopened in SAX
     std::shared_ptr<QByteArray> package_bytes;
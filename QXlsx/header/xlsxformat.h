@@ -216,14 +216,18 @@ public:
     bool fontIndexValid() const;
     int fontIndex() const;
     QByteArray fontKey() const;
+    quint64 fontHash() const;
     bool borderIndexValid() const;
     QByteArray borderKey() const;
+    quint64 borderHash() const;
     int borderIndex() const;
     bool fillIndexValid() const;
     QByteArray fillKey() const;
+    quint64 fillHash() const;
     int fillIndex() const;
 
     QByteArray formatKey() const;
+    quint64 formatHash() const;
     bool xfIndexValid() const;
     int xfIndex() const;
     bool dxfIndexValid() const;
@@ -4,9 +4,12 @@
 
 #include "xlsxformat.h"
 
-#include <QMap>
+#include <array>
+
 #include <QSet>
 #include <QSharedData>
+#include <QVarLengthArray>
+#include <QVariant>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -88,10 +91,38 @@ public:
         P_ENDID
     };
 
+    // Property groups, each with its own structural hash
+    enum PropertyGroup {
+        G_NumFmt,
+        G_Font,
+        G_Border,
+        G_Fill,
+        G_Alignment,
+        G_Protection,
+        G_Count
+    };
+
+    struct PropertyEntry {
+        int id;
+        QVariant value;
+    };
+
     FormatPrivate();
     FormatPrivate(const FormatPrivate &other);
     ~FormatPrivate();
 
+    const QVariant *find(int propertyId) const;
+    quint64 hash() const;
+
+    static PropertyGroup groupOf(int propertyId);
+    static quint64 propertyHash(int propertyId, const QVariant &value);
+    static bool sameValue(const QVariant &a, const QVariant &b);
+    // Compares the properties with ids in [firstId, endId); null means no properties.
+    static bool sameProperties(const FormatPrivate *a,
+                               const FormatPrivate *b,
+                               int firstId,
+                               int endId);
+
     bool dirty; // The key re-generation is need.
     QByteArray formatKey;
 
@@ -119,7 +150,10 @@ public:
 
     int theme;
 
-    QMap<int, QVariant> properties;
+    // Sorted by id. The group hashes are sums of propertyHash() over the
+    // group's properties, kept up to date by Format::setProperty().
+    QVarLengthArray<PropertyEntry, 8> properties;
+    std::array<quint64, G_Count> groupHash;
 };
 
 QT_END_NAMESPACE_XLSX
@@ -0,0 +1,21 @@
+// xlsxparallel_p.h
+
+#ifndef XLSXPARALLEL_P_H
+#define XLSXPARALLEL_P_H
+
+#include "xlsxglobal.h"
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  Runs job(0) .. job(count - 1), spreading the calls over the global thread
+  pool, and returns once all of them have finished. The calling thread runs
+  jobs too, so this makes progress even when the pool is saturated. Jobs may
+  run in any order and must not depend on each other.
+ */
+void parallelFor(int count, const std::function<void(int)> &job);
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXPARALLEL_P_H
@@ -1,6 +1,7 @@
 #ifndef XLSXREADSAX_H
 #define XLSXREADSAX_H
 
+#include <QIODevice>
 #include <QXmlStreamReader>
 #include <QString>
 #include <QVariant>
@@ -35,6 +36,13 @@ bool read_sheet_xml_sax(const QByteArray& sheet_xml,
                         const QStringList* shared_strings, // nullptr 가능
                         const sax_cell_callback& on_cell);
 
+// Parse sheet.xml with SAX while it is read from a device, e.g. a zip entry
+// inflated on the fly, so cells are emitted before the whole sheet is read
+bool read_sheet_xml_sax(QIODevice* sheet_xml,
+                        const sax_options& opt,
+                        const QStringList* shared_strings, // nullptr 가능
+                        const sax_cell_callback& on_cell);
+
 } // namespace QXlsx
 
 #endif // XLSXREADSAX_H
@@ -0,0 +1,75 @@
+// xlsxsheetdatawriter_p.h
+
+#ifndef XLSXSHEETDATAWRITER_P_H
+#define XLSXSHEETDATAWRITER_P_H
+
+#include "xlsxglobal.h"
+
+#include <cstring>
+#include <vector>
+
+#include <QString>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+  Byte level writer for the <sheetData> element of a worksheet.
+
+  Everything is encoded straight into a fixed size UTF-8 buffer that is
+  flushed to the device when full, so the per-cell path needs no QString
+  temporaries. Only what sheetData needs is supported: literal markup,
+  integers, doubles, cell references and escaped text.
+ */
+class SheetDataWriter
+{
+public:
+    explicit SheetDataWriter(QIODevice *device);
+    ~SheetDataWriter();
+
+    template <size_t N>
+    void writeLiteral(const char (&literal)[N])
+    {
+        writeRaw(literal, N - 1);
+    }
+    void writeRaw(const char *data, size_t size);
+    void writeInt(qint64 value);
+    void writeDouble(double value);
+    void writeCellReference(int row, int column);
+    void writeEscaped(const QString &text);
+
+    void flush();
+    bool hasError() const { return m_error; }
+
+private:
+    char *reserve(size_t size);
+    void writeToDevice(const char *data, size_t size);
+
+    QIODevice *m_device;
+    std::vector<char> m_buffer;
+    size_t m_used = 0;
+    bool m_error  = false;
+};
+
+inline void SheetDataWriter::writeRaw(const char *data, size_t size)
+{
+    if (size > m_buffer.size()) {
+        flush();
+        writeToDevice(data, size);
+        return;
+    }
+    std::memcpy(reserve(size), data, size);
+}
+
+inline char *SheetDataWriter::reserve(size_t size)
+{
+    if (m_used + size > m_buffer.size())
+        flush();
+    char *out = m_buffer.data() + m_used;
+    m_used += size;
+    return out;
+}
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXSHEETDATAWRITER_P_H
@@ -87,6 +87,14 @@ private:
     friend class Format;
     // friend class ::StylesTest;
 
+    // Formats keyed by the structural hash of one property group. Formats
+    // sharing a hash are told apart by comparing properties in [firstId, endId).
+    using FormatHash = QMultiHash<quint64, Format>;
+    static FormatHash::iterator
+        findFormat(FormatHash &hash, quint64 key, const Format &format, int firstId, int endId);
+    static void
+        insertFormat(FormatHash &hash, quint64 key, const Format &format, int firstId, int endId);
+
     void fixNumFmt(const Format &format);
 
     void writeNumFmts(QXmlStreamWriter &writer) const;
@@ -131,18 +139,18 @@ private:
     QList<Format> m_fontsList;
     QList<Format> m_fillsList;
     QList<Format> m_bordersList;
-    QHash<QByteArray, Format> m_fontsHash;
-    QHash<QByteArray, Format> m_fillsHash;
-    QHash<QByteArray, Format> m_bordersHash;
+    FormatHash m_fontsHash;
+    FormatHash m_fillsHash;
+    FormatHash m_bordersHash;
 
     QVector<QColor> m_indexedColors;
     bool m_isIndexedColorsDefault;
 
     QList<Format> m_xf_formatsList;
-    QHash<QByteArray, Format> m_xf_formatsHash;
+    FormatHash m_xf_formatsHash;
 
     QList<Format> m_dxf_formatsList;
-    QHash<QByteArray, Format> m_dxf_formatsHash;
+    FormatHash m_dxf_formatsHash;
 
     bool m_emptyFormatAdded;
 };
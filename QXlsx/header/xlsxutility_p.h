@@ -35,6 +35,12 @@ QString unescapeSheetName(const QString &sheetName);
 
 bool isSpaceReserveNeeded(const QString &string);
 
+enum class CellStringKind { Text, Formula, Hyperlink, Number };
+CellStringKind classifyCellString(const QString &string,
+                                  bool detectHyperlinks,
+                                  bool detectNumbers,
+                                  double *number);
+
 QString convertSharedFormula(const QString &rootFormula,
                              const CellReference &rootCell,
                              const CellReference &cell);
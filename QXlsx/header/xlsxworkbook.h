@@ -25,6 +25,7 @@ class DocumentPrivate;
 class MediaFile;
 class Chart;
 class Chartsheet;
+class Format;
 class Worksheet;
 class WorkbookPrivate;
 
@@ -67,6 +68,7 @@ public:
     void setDefaultDateFormat(const QString &format);
     void setWriteDatesAsText(bool enable);
     bool writeDatesAsText() const;
+    int registerStyle(const Format &format);
 
     // internal used member
     void addMediaFile(std::shared_ptr<MediaFile> media, bool force = false);
@@ -18,6 +18,7 @@
 #include <QStringList>
 #include <QUrl>
 #include <QVariant>
+#include <QVector>
 
 class WorksheetTest;
 
@@ -46,6 +47,9 @@ private:
     Worksheet(const QString &sheetName, int sheetId, Workbook *book, CreateFlag flag);
     Worksheet *copy(const QString &distName, int distId) const override;
 
+public:
+    enum CellStyle { KeepCellStyle = -1, ClearCellStyle = -2 };
+
 public:
     ~Worksheet();
 
@@ -62,6 +66,7 @@ public:
                      const QString &value,
                      const Format &format = Format());
     bool writeString(int row, int column, const QString &value, const Format &format = Format());
+    bool writeString(int row, int column, const QString &value, int style);
     bool writeString(const CellReference &row_column,
                      const RichString &value,
                      const Format &format = Format());
@@ -74,11 +79,13 @@ public:
                            int column,
                            const QString &value,
                            const Format &format = Format());
+    bool writeInlineString(int row, int column, const QString &value, int style);
 
     bool writeNumeric(const CellReference &row_column,
                       double value,
                       const Format &format = Format());
     bool writeNumeric(int row, int column, double value, const Format &format = Format());
+    bool writeNumeric(int row, int column, double value, int style);
 
     bool writeFormula(const CellReference &row_column,
                       const CellFormula &formula,
@@ -89,27 +96,33 @@ public:
                       const CellFormula &formula,
                       const Format &format = Format(),
                       double result        = 0);
+    bool writeFormula(int row, int column, const CellFormula &formula, int style, double result = 0);
 
     bool writeBlank(const CellReference &row_column, const Format &format = Format());
     bool writeBlank(int row, int column, const Format &format = Format());
+    bool writeBlank(int row, int column, int style);
 
     bool writeBool(const CellReference &row_column, bool value, const Format &format = Format());
     bool writeBool(int row, int column, bool value, const Format &format = Format());
+    bool writeBool(int row, int column, bool value, int style);
 
     bool writeDateTime(const CellReference &row_column,
                        const QDateTime &dt,
                        const Format &format = Format());
     bool writeDateTime(int row, int column, const QDateTime &dt, const Format &format = Format());
+    bool writeDateTime(int row, int column, const QDateTime &dt, int style);
 
     // dev67
     bool writeDate(const CellReference &row_column,
                    const QDate &dt,
                    const Format &format = Format());
     bool writeDate(int row, int column, const QDate &dt, const Format &format = Format());
+    bool writeDate(int row, int column, const QDate &dt, int style);
 
     bool
         writeTime(const CellReference &row_column, const QTime &t, const Format &format = Format());
     bool writeTime(int row, int column, const QTime &t, const Format &format = Format());
+    bool writeTime(int row, int column, const QTime &t, int style);
 
     bool writeHyperlink(const CellReference &row_column,
                         const QUrl &url,
@@ -123,6 +136,20 @@ public:
                         const QString &display = QString(),
                         const QString &tip     = QString());
 
+    bool writeRow(int row,
+                  int column,
+                  const QVariant *values,
+                  int count,
+                  const int *styles = nullptr);
+    bool writeRow(int row,
+                  int column,
+                  const QVector<QVariant> &values,
+                  const QVector<int> &styles = QVector<int>());
+    bool appendRow(const QVector<QVariant> &values, const QVector<int> &styles = QVector<int>());
+    bool writeColumn(int row, int column, const QVector<double> &values, int style = -1);
+    bool writeColumn(int row, int column, const QStringList &values, int style = -1);
+    bool writeColumn(int row, int column, const QVector<QDateTime> &values, int style = -1);
+
     bool addDataValidation(const DataValidation &validation);
     bool addConditionalFormatting(const ConditionalFormatting &cf);
 
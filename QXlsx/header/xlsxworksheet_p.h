@@ -6,6 +6,7 @@
 #include "xlsxabstractsheet_p.h"
 #include "xlsxcell.h"
 #include "xlsxcellformula.h"
+#include "xlsxcelltable_p.h"
 #include "xlsxconditionalformatting.h"
 #include "xlsxdatavalidation.h"
 #include "xlsxworksheet.h"
@@ -13,7 +14,6 @@
 #include <QHash>
 #include <QImage>
 #include <QObject>
-#include <QRegularExpression>
 #include <QString>
 #include <QVector>
 
@@ -23,6 +23,7 @@ class QXmlStreamReader;
 QT_BEGIN_NAMESPACE_XLSX
 
 class SharedStrings;
+class SheetDataWriter;
 
 struct XlsxHyperlinkData {
     enum LinkType { External, Internal };
@@ -132,56 +133,6 @@ struct XlsxColumnInfo {
     bool collapsed;
 };
 
-class CellTable
-{
-public:
-    static QList<int> sorteIntList(QList<int> &&keys)
-    {
-        std::sort(keys.begin(), keys.end());
-        return keys;
-    }
-
-    inline QList<int> sortedRows() const
-    {
-        QList<int> keys = cells.keys();
-        std::sort(keys.begin(), keys.end());
-        return keys;
-    }
-
-    void setValue(int row, int column, const std::shared_ptr<Cell> &cell)
-    {
-        cells[row].insert(column, cell);
-        firstRow    = qMin(firstRow, row);
-        firstColumn = qMin(firstColumn, column);
-        lastRow     = qMin(lastRow, row);
-        lastColumn  = qMin(lastColumn, column);
-    }
-
-    std::shared_ptr<Cell> cellAt(int row, int column) const
-    {
-        return cells.value(row).value(column);
-    }
-
-    bool contains(int row, int column) const
-    {
-        auto it = cells.find(row);
-        if (it != cells.end()) {
-            return it->contains(column);
-        }
-        return false;
-    }
-
-    bool isEmpty() const { return cells.isEmpty(); }
-
-    // It's faster with a single QHash, but in Qt5 it's capacity limits
-    // how much cells we can hold
-    QHash<int, QHash<int, std::shared_ptr<Cell>>> cells;
-    int firstRow    = -1;
-    int firstColumn = -1;
-    int lastRow     = -1;
-    int lastColumn  = -1;
-};
-
 class WorksheetPrivate : public AbstractSheetPrivate
 {
     Q_DECLARE_PUBLIC(Worksheet)
@@ -192,17 +143,31 @@ public:
 
 public:
     int checkDimensions(int row, int col, bool ignore_row = false, bool ignore_col = false);
+    int checkDimensions(const CellRange &range);
     Format cellFormat(int row, int col) const;
+    qint32 cellStyle(int row, int col, int style) const;
+    static qint32 cellStyle(const CellTable::Row *row, int col, int style);
+    void setCell(int row,
+                 int column,
+                 Cell::CellType type,
+                 const QVariant &value,
+                 qint32 style,
+                 const CellFormula &formula = CellFormula());
+    QVariant storedValue(const CellData &cell) const;
+    qint32 defaultDateStyle() const;
+    qint32 defaultTimeStyle() const;
+    std::shared_ptr<Cell> createCell(const CellData &cell) const;
     QString generateDimensionString() const;
-    void calculateSpans() const;
+    bool blockSpan(int block, int *first, int *last) const;
     void splitColsInfo(int colFirst, int colLast);
     void validateDimension();
 
-    void saveXmlSheetData(QXmlStreamWriter &writer) const;
-    void saveXmlCellData(QXmlStreamWriter &writer,
+    void saveXmlSheetData(SheetDataWriter &writer) const;
+    void saveXmlCellData(SheetDataWriter &writer,
                          int row,
                          int col,
-                         std::shared_ptr<Cell> cell) const;
+                         const CellData &cell,
+                         int rowStyle) const;
     void saveXmlMergeCells(QXmlStreamWriter &writer) const;
     void saveXmlHyperlinks(QXmlStreamWriter &writer) const;
     void saveXmlDrawings(QXmlStreamWriter &writer) const;
@@ -243,7 +208,6 @@ public:
 
     CellRange dimension;
 
-    mutable QHash<int, QString> row_spans;
     QHash<int, double> row_sizes;
     QHash<int, double> col_sizes;
 
@@ -284,8 +248,6 @@ public:
     bool showOutlineSymbols;
     bool showWhiteSpace;
 
-    QRegularExpression urlPattern;
-
 private:
     static double calculateColWidth(int characters);
 };
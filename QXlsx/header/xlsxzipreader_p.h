@@ -5,15 +5,27 @@
 
 #include "xlsxglobal.h"
 
+#include <memory>
+
+#include <QHash>
 #include <QIODevice>
-#include <QScopedPointer>
 #include <QStringList>
 #include <QVector>
 
-class QZipReader;
+class QFile;
 
 QT_BEGIN_NAMESPACE_XLSX
 
+/*
+  Reads the entries of a zip archive, classic or ZIP64, from a file or a
+  random access device.
+
+  Files are memory-mapped and in-memory buffers are used in place, so only
+  the pages of the parts that are asked for are touched. The central
+  directory is indexed on first use, and entries are inflated on demand,
+  either whole or incrementally through openFile(). Devices that can be
+  neither mapped nor addressed are read with seeks.
+ */
 class ZipReader
 {
 public:
@@ -23,12 +35,43 @@ public:
     bool exists() const;
     QStringList filePaths() const;
     QByteArray fileData(const QString &fileName) const;
+    QByteArray fileDataView(const QString &fileName) const;
+    qint64 fileSize(const QString &fileName) const;
+    std::unique_ptr<QIODevice> openFile(const QString &fileName) const;
 
 private:
+    struct Entry {
+        qint64 headerOffset     = 0;
+        qint64 compressedSize   = 0;
+        qint64 uncompressedSize = 0;
+        quint32 crc             = 0;
+        quint16 method          = 0;
+    };
+
+    class EntryDevice;
+
     Q_DISABLE_COPY(ZipReader)
     void init();
-    QScopedPointer<QZipReader> m_reader;
-    QStringList m_filePaths;
+    void ensureIndex() const;
+    bool readCentralDirectory() const;
+    const Entry *findEntry(const QString &fileName) const;
+    qint64 dataOffset(const Entry &entry) const;
+    QByteArray entryData(const QString &fileName, bool copy) const;
+    QByteArray readAt(qint64 offset, qint64 size) const;
+
+    std::unique_ptr<QFile> m_ownedFile;
+    QIODevice *m_device;
+    QFile *m_mappedFile = nullptr; // set while m_data is a mapping of it
+    const char *m_data  = nullptr; // the whole archive, mapped or buffered
+    qint64 m_size       = 0;
+    bool m_open         = false;
+
+    // Central directory index, built by ensureIndex()
+    mutable QVector<Entry> m_entries;
+    mutable QHash<QString, int> m_index;
+    mutable QStringList m_filePaths;
+    mutable bool m_indexed = false;
+    mutable bool m_valid   = false;
 };
 
 QT_END_NAMESPACE_XLSX
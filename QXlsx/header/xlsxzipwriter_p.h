@@ -5,27 +5,102 @@
 
 #include "xlsxglobal.h"
 
+#include <memory>
+
+#include <QByteArray>
 #include <QIODevice>
 #include <QString>
-
-class QZipWriter;
+#include <QVector>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+/*
+  Writes a zip archive of package parts, in the order they are added.
+
+  The data of an entry can be compressed ahead of time with compress(),
+  which may run on any thread. That lets the package parts be deflated
+  in parallel and still be written in a fixed order, so the archive does
+  not depend on how the work was scheduled. Large entries are also split
+  into blocks that are deflated in parallel, the way pigz does.
+
+  Parts too large to hold in memory are written through openFile(), which
+  streams them into the archive as they are produced. Entries, offsets and
+  archives past the 4 GiB or 65535 entry limits of classic zip get ZIP64
+  records; smaller archives keep the classic layout, except that streamed
+  entries always use ZIP64 local headers and data descriptors, because
+  their size is only known once they are written.
+ */
 class ZipWriter
 {
 public:
+    enum CompressionPolicy {
+        AutoCompress,   // deflate, but store entries that deflate cannot shrink
+        AlwaysCompress, // always deflate
+        NeverCompress   // always store
+    };
+
+    // zlib levels: 0 (store) to 9 (smallest), -1 for zlib's default (6)
+    enum { DefaultCompressionLevel = -1 };
+
+    struct CompressedEntry {
+        QByteArray data; // deflated, or stored as is if deflate does not help
+        quint32 crc             = 0;
+        qint64 uncompressedSize = 0;
+        bool deflated           = false;
+    };
+
     explicit ZipWriter(const QString &filePath);
     explicit ZipWriter(QIODevice *device);
     ~ZipWriter();
 
+    static CompressedEntry compress(const QByteArray &data,
+                                    int level                = DefaultCompressionLevel,
+                                    CompressionPolicy policy = AutoCompress);
+
+    // Used by the addFile() overloads that compress the data themselves
+    void setCompressionLevel(int level);
+    int compressionLevel() const;
+    void setCompressionPolicy(CompressionPolicy policy);
+    CompressionPolicy compressionPolicy() const;
+
     void addFile(const QString &filePath, QIODevice *device);
     void addFile(const QString &filePath, const QByteArray &data);
+    void addFile(const QString &filePath, const CompressedEntry &entry);
+    QIODevice *openFile(const QString &filePath);
+    void closeFile();
     bool error() const;
     void close();
 
 private:
-    QZipWriter *m_writer;
+    struct DirectoryEntry {
+        QByteArray name;
+        quint16 flags            = 0;
+        quint16 method           = 0;
+        quint32 crc              = 0;
+        quint64 compressedSize   = 0;
+        quint64 uncompressedSize = 0;
+        quint64 headerOffset     = 0;
+    };
+
+    class EntryDevice;
+
+    void init();
+    DirectoryEntry newEntry(const QString &filePath) const;
+    void writeLocalHeader(const DirectoryEntry &entry);
+    void writeCentralDirectory();
+    void write(const QByteArray &bytes);
+
+    std::unique_ptr<QIODevice> m_file;
+    std::unique_ptr<EntryDevice> m_entry; // streamed entry opened by openFile()
+    QIODevice *m_device;
+    QVector<DirectoryEntry> m_entries;
+    qint64 m_offset            = 0;
+    int m_level                = DefaultCompressionLevel;
+    CompressionPolicy m_policy = AutoCompress;
+    quint16 m_dosTime          = 0;
+    quint16 m_dosDate          = 0;
+    bool m_error               = false;
+    bool m_closed              = false;
 };
 
 QT_END_NAMESPACE_XLSX
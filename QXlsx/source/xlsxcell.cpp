@@ -39,6 +39,8 @@ CellPrivate::CellPrivate(const CellPrivate *const cp)
   \inmodule QtXlsx
   \brief The Cell class provides a API that is used to handle the worksheet cell.
 
+  Worksheets store cells in a packed form. A Cell is built when
+  Worksheet::cellAt() is called and is a snapshot of the cell at that time.
 */
 
 /*!
@@ -313,6 +315,9 @@ bool Cell::isRichString() const
     return d->richString.isRichString();
 }
 
+/*!
+ * Return the xf index of the cell format, or -1 if the cell has none.
+ */
 qint32 Cell::styleNumber() const
 {
     Q_D(const Cell);
@@ -0,0 +1,261 @@
+// xlsxcelltable.cpp
+
+#include "xlsxcelltable_p.h"
+
+#include <algorithm>
+#include <iterator>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+// Rows per block. Inserting a row in the middle of the sheet moves at
+// most this many rows; appending in order never moves any.
+const size_t kBlockCapacity = 256;
+
+// A dense row may grow while its span stays within twice its cell count
+// plus this slack, so short rows with small gaps remain dense.
+const int kDenseSlack = 16;
+
+} // namespace
+
+const CellData *CellTable::Row::cellAt(int column) const
+{
+    if (m_dense) {
+        const int index = column - m_firstColumn;
+        if (index < 0 || index >= int(m_cells.size()) || m_cells[index].isNull())
+            return nullptr;
+        return &m_cells[index];
+    }
+
+    auto it = std::lower_bound(m_columns.begin(), m_columns.end(), column);
+    if (it == m_columns.end() || *it != column)
+        return nullptr;
+    return &m_cells[it - m_columns.begin()];
+}
+
+/*!
+  Stores \a cell at \a column and returns the cell it replaced, which is
+  null if the column was empty.
+ */
+CellData CellTable::Row::setCell(int column, const CellData &cell)
+{
+    if (m_cells.empty()) {
+        m_dense       = true;
+        m_firstColumn = column;
+        m_cells.push_back(cell);
+        m_count = 1;
+        return CellData();
+    }
+
+    if (m_dense) {
+        const int size  = int(m_cells.size());
+        const int index = column - m_firstColumn;
+        if (index >= 0 && index < size) {
+            const CellData old = m_cells[index];
+            m_cells[index]     = cell;
+            if (old.isNull())
+                ++m_count;
+            return old;
+        }
+
+        const int first = qMin(m_firstColumn, column);
+        const int last  = qMax(m_firstColumn + size - 1, column);
+        if (last - first + 1 <= 2 * (m_count + 1) + kDenseSlack) {
+            if (index < 0) {
+                m_cells.insert(m_cells.begin(), size_t(-index), CellData());
+                m_firstColumn = column;
+                m_cells.front() = cell;
+            } else {
+                m_cells.resize(size_t(index) + 1);
+                m_cells.back() = cell;
+            }
+            ++m_count;
+            return CellData();
+        }
+        makeSparse();
+    }
+
+    auto it = std::lower_bound(m_columns.begin(), m_columns.end(), column);
+    const auto pos = it - m_columns.begin();
+    if (it != m_columns.end() && *it == column) {
+        const CellData old = m_cells[pos];
+        m_cells[pos]       = cell;
+        return old;
+    }
+    m_columns.insert(it, column);
+    m_cells.insert(m_cells.begin() + pos, cell);
+    ++m_count;
+    return CellData();
+}
+
+void CellTable::Row::makeSparse()
+{
+    std::vector<int> columns;
+    std::vector<CellData> cells;
+    columns.reserve(m_count + 1);
+    cells.reserve(m_count + 1);
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        if (!m_cells[i].isNull()) {
+            columns.push_back(m_firstColumn + int(i));
+            cells.push_back(m_cells[i]);
+        }
+    }
+    m_columns.swap(columns);
+    m_cells.swap(cells);
+    m_dense = false;
+}
+
+void CellTable::setValue(int row, int column, const CellData &cell)
+{
+    storeCell(rowForWrite(row), column, cell);
+    extendBounds(row, column, column);
+}
+
+/*!
+  Stores a run of cells with a single row lookup and bounds update, which
+  is what makes writing a whole row cheaper than writing its cells one by
+  one.
+ */
+void CellTable::setCells(int row, int column, const CellData *cells, int count)
+{
+    int first = 0;
+    while (first < count && cells[first].isNull())
+        ++first;
+    if (first == count)
+        return;
+    int last = count - 1;
+    while (cells[last].isNull())
+        --last;
+
+    Row &r = rowForWrite(row);
+    if (r.m_cells.empty())
+        r.m_cells.reserve(size_t(last - first + 1));
+    for (int i = first; i <= last; ++i) {
+        if (!cells[i].isNull())
+            storeCell(r, column + i, cells[i]);
+    }
+    extendBounds(row, column + first, column + last);
+}
+
+const CellData *CellTable::cellAt(int row, int column) const
+{
+    const Row *r = findRow(row);
+    return r ? r->cellAt(column) : nullptr;
+}
+
+const CellTable::Row *CellTable::findRow(int row) const
+{
+    auto blockIt = findBlock(row);
+    if (blockIt == m_blocks.end())
+        return nullptr;
+
+    const std::vector<Row> &rows = blockIt->rows;
+    auto rowIt                   = std::lower_bound(
+        rows.begin(), rows.end(), row, [](const Row &r, int value) { return r.m_row < value; });
+    if (rowIt == rows.end() || rowIt->m_row != row)
+        return nullptr;
+    return &*rowIt;
+}
+
+qint32 CellTable::addExtra(const QVariant &value, const CellFormula &formula)
+{
+    CellExtra extra;
+    extra.value   = value;
+    extra.formula = formula;
+    if (!m_freeExtras.empty()) {
+        const qint32 index = m_freeExtras.back();
+        m_freeExtras.pop_back();
+        m_extras[size_t(index)] = extra;
+        return index;
+    }
+    m_extras.push_back(extra);
+    return qint32(m_extras.size() - 1);
+}
+
+void CellTable::storeCell(Row &row, int column, const CellData &cell)
+{
+    const CellData old = row.setCell(column, cell);
+    if (old.isNull())
+        ++m_cellCount;
+    else if (old.flags & CellData::HasExtra)
+        releaseExtra(old.index);
+}
+
+void CellTable::extendBounds(int row, int first, int last)
+{
+    if (firstRow == -1 || row < firstRow)
+        firstRow = row;
+    if (firstColumn == -1 || first < firstColumn)
+        firstColumn = first;
+    lastRow    = qMax(lastRow, row);
+    lastColumn = qMax(lastColumn, last);
+}
+
+void CellTable::releaseExtra(qint32 index)
+{
+    m_extras[size_t(index)] = CellExtra();
+    m_freeExtras.push_back(index);
+}
+
+void CellTable::clear()
+{
+    m_blocks.clear();
+    m_extras.clear();
+    m_freeExtras.clear();
+    m_cellCount = 0;
+    firstRow    = -1;
+    firstColumn = -1;
+    lastRow     = -1;
+    lastColumn  = -1;
+}
+
+// First block whose last row is not below \a row.
+std::vector<CellTable::Block>::const_iterator CellTable::findBlock(int row) const
+{
+    return std::lower_bound(m_blocks.begin(), m_blocks.end(), row, [](const Block &b, int value) {
+        return b.rows.back().m_row < value;
+    });
+}
+
+CellTable::Row &CellTable::rowForWrite(int row)
+{
+    // Fast path: rows written in ascending order are appended to the last block
+    if (m_blocks.empty() || m_blocks.back().rows.back().m_row < row) {
+        if (m_blocks.empty() || m_blocks.back().rows.size() >= kBlockCapacity) {
+            m_blocks.push_back(Block());
+            m_blocks.back().rows.reserve(kBlockCapacity);
+        }
+        std::vector<Row> &rows = m_blocks.back().rows;
+        rows.push_back(Row());
+        rows.back().m_row = row;
+        return rows.back();
+    }
+
+    const size_t blockIndex = size_t(findBlock(row) - m_blocks.cbegin());
+    std::vector<Row> &rows  = m_blocks[blockIndex].rows;
+    auto rowIt              = std::lower_bound(
+        rows.begin(), rows.end(), row, [](const Row &r, int value) { return r.m_row < value; });
+    if (rowIt != rows.end() && rowIt->m_row == row)
+        return *rowIt;
+
+    const size_t pos = size_t(rowIt - rows.begin());
+    rows.insert(rowIt, Row());
+    rows[pos].m_row = row;
+    if (rows.size() <= kBlockCapacity)
+        return rows[pos];
+
+    // Split a full block in half; the new block follows the old one
+    const size_t half = rows.size() / 2;
+    Block upper;
+    upper.rows.reserve(kBlockCapacity);
+    std::move(rows.begin() + half, rows.end(), std::back_inserter(upper.rows));
+    rows.erase(rows.begin() + half, rows.end());
+    m_blocks.insert(m_blocks.begin() + blockIndex + 1, std::move(upper));
+
+    if (pos < half)
+        return m_blocks[blockIndex].rows[pos];
+    return m_blocks[blockIndex + 1].rows[pos - half];
+}
+
+QT_END_NAMESPACE_XLSX
@@ -9,6 +9,7 @@
 #include "xlsxdocument_p.h"
 #include "xlsxdrawing_p.h"
 #include "xlsxmediafile_p.h"
+#include "xlsxparallel_p.h"
 #include "xlsxrelationships_p.h"
 #include "xlsxsharedstrings_p.h"
 #include "xlsxstyles_p.h"
@@ -17,6 +18,7 @@
 #include "xlsxworkbook.h"
 #include "xlsxworkbook_p.h"
 #include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
 #include "xlsxzipreader_p.h"
 #include "xlsxzipwriter_p.h"
 
@@ -29,6 +31,8 @@
 #include <QPointF>
 #include <QTemporaryFile>
 
+#include <vector>
+
 /*
         From Wikipedia: The Open Packaging Conventions (OPC) is a
         container-file technology initially created by Microsoft to store
@@ -152,10 +156,18 @@ std::string copyTag(const std::string &sFrom, const std::string &sTo, const std:
 }
 } // namespace xlsxDocumentCpp
 
+namespace {
+// Worksheets with more cells than this are streamed into the archive
+// rather than serialized in memory, which bounds the memory a save needs.
+// A cell takes a few dozen bytes of XML, so this is some tens of MiB.
+const int kStreamedSheetCells = 1 << 20;
+} // namespace
+
 DocumentPrivate::DocumentPrivate(Document *p)
     : q_ptr(p)
     , defaultPackageName(QStringLiteral("Book1.xlsx"))
     , isLoad(false)
+    , compressionLevel(ZipWriter::DefaultCompressionLevel)
 {
 }
 
@@ -329,15 +341,47 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     ZipWriter zipWriter(device);
     if (zipWriter.error())
         return false;
+    zipWriter.setCompressionLevel(compressionLevel);
 
     contentTypes->clearOverrides();
 
     DocPropsApp docPropsApp(DocPropsApp::F_NewFromScratch);
     DocPropsCore docPropsCore(DocPropsCore::F_NewFromScratch);
 
-    // save worksheet xml files
     QList<std::shared_ptr<AbstractSheet>> worksheets =
         workbook->getSheetsByTypes(AbstractSheet::ST_WorkSheet);
+    QList<std::shared_ptr<AbstractSheet>> chartsheets =
+        workbook->getSheetsByTypes(AbstractSheet::ST_ChartSheet);
+
+    // Serialize and deflate the large parts on the thread pool first. Each
+    // part is saved by one job and only reads shared workbook state, and the
+    // results are written below in the usual order, so the package is the
+    // same however the jobs were scheduled. Worksheets too large to hold
+    // in memory are left out and streamed into the archive in turn.
+    QList<const AbstractOOXmlFile *> parallelParts;
+    QVector<bool> streamedSheets(worksheets.size(), false);
+    for (int i = 0; i < worksheets.size(); ++i) {
+        const Worksheet *sheet = static_cast<const Worksheet *>(worksheets[i].get());
+        if (sheet->d_func()->cellTable.cellCount() > kStreamedSheetCells)
+            streamedSheets[i] = true;
+        else
+            parallelParts.append(sheet);
+    }
+    for (int i = 0; i < chartsheets.size(); ++i)
+        parallelParts.append(chartsheets[i].get());
+    const bool hasSharedStrings = !workbook->sharedStrings()->isEmpty();
+    if (hasSharedStrings)
+        parallelParts.append(workbook->sharedStrings());
+    parallelParts.append(workbook->styles());
+
+    std::vector<ZipWriter::CompressedEntry> compressedParts(size_t(parallelParts.size()));
+    parallelFor(int(parallelParts.size()), [&](int i) {
+        compressedParts[size_t(i)] = ZipWriter::compress(parallelParts.at(i)->saveToXmlData(),
+                                                         compressionLevel);
+    });
+    int nextPart = 0;
+
+    // save worksheet xml files
     if (!worksheets.isEmpty())
         docPropsApp.addHeadingPair(QStringLiteral("Worksheets"), worksheets.size());
 
@@ -346,8 +390,13 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
 
-        zipWriter.addFile(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
+        const QString sheetPath = QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1);
+        if (streamedSheets[i]) {
+            sheet->saveToXmlFile(zipWriter.openFile(sheetPath));
+            zipWriter.closeFile();
+        } else {
+            zipWriter.addFile(sheetPath, compressedParts[size_t(nextPart++)]);
+        }
 
         Relationships *rel = sheet->relationships();
         if (!rel->isEmpty())
@@ -356,8 +405,6 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     }
 
     // save chartsheet xml files
-    QList<std::shared_ptr<AbstractSheet>> chartsheets =
-        workbook->getSheetsByTypes(AbstractSheet::ST_ChartSheet);
     if (!chartsheets.isEmpty())
         docPropsApp.addHeadingPair(QStringLiteral("Chartsheets"), chartsheets.size());
     for (int i = 0; i < chartsheets.size(); ++i) {
@@ -366,7 +413,7 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         docPropsApp.addPartTitle(sheet->sheetName());
 
         zipWriter.addFile(QStringLiteral("xl/chartsheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
+                          compressedParts[size_t(nextPart++)]);
         Relationships *rel = sheet->relationships();
         if (!rel->isEmpty())
             zipWriter.addFile(QStringLiteral("xl/chartsheets/_rels/sheet%1.xml.rels").arg(i + 1),
@@ -417,19 +464,20 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
     zipWriter.addFile(QStringLiteral("docProps/core.xml"), docPropsCore.saveToXmlData());
 
     // save sharedStrings xml file
-    if (!workbook->sharedStrings()->isEmpty()) {
+    if (hasSharedStrings) {
         contentTypes->addSharedString();
         zipWriter.addFile(QStringLiteral("xl/sharedStrings.xml"),
-                          workbook->sharedStrings()->saveToXmlData());
+                          compressedParts[size_t(nextPart++)]);
     }
 
     // save calc chain [dev16]
+    const ZipWriter::CompressedEntry &stylesPart = compressedParts[size_t(nextPart++)];
     contentTypes->addCalcChain();
-    zipWriter.addFile(QStringLiteral("xl/calcChain.xml"), workbook->styles()->saveToXmlData());
+    zipWriter.addFile(QStringLiteral("xl/calcChain.xml"), stylesPart);
 
     // save styles xml file
     contentTypes->addStyles();
-    zipWriter.addFile(QStringLiteral("xl/styles.xml"), workbook->styles()->saveToXmlData());
+    zipWriter.addFile(QStringLiteral("xl/styles.xml"), stylesPart);
 
     // save theme xml file
     contentTypes->addTheme();
@@ -1349,6 +1397,27 @@ bool Document::save() const
     return saveAs(name);
 }
 
+/*!
+ * Sets the zlib compression \a level used when the document is saved,
+ * from 1 (fastest) to 9 (smallest). 0 stores the parts uncompressed and
+ * -1 selects zlib's default level, which is also the initial value.
+ */
+void Document::setCompressionLevel(int level)
+{
+    Q_D(Document);
+    d->compressionLevel = qBound(-1, level, 9);
+}
+
+/*!
+ * Returns the compression level used when the document is saved.
+ * \sa setCompressionLevel()
+ */
+int Document::compressionLevel() const
+{
+    Q_D(const Document);
+    return d->compressionLevel;
+}
+
 /*!
  * Saves the document to the file with the given \a name.
  * Returns true if saved successfully.
@@ -1599,12 +1668,13 @@ bool Document::read_sheet_sax(int sheet_index,
         return false;
 
     const QString sheet_path = abs_sheet->filePath();
-    const QByteArray sheet_xml = zip.fileData(sheet_path);
 
-    if (sheet_xml.isEmpty())
+    // inflate the sheet in chunks while it is parsed, instead of loading it whole
+    const std::unique_ptr<QIODevice> sheet_xml = zip.openFile(sheet_path);
+    if (!sheet_xml || sheet_xml->atEnd())
         return false;
 
-    return QXlsx::read_sheet_xml_sax(sheet_xml, opt,
+    return QXlsx::read_sheet_xml_sax(sheet_xml.get(), opt,
                                      opt.resolve_shared_strings ? &shared_strings : nullptr,
                                      on_cell);
 }
@@ -6,11 +6,71 @@
 #include "xlsxformat_p.h"
 #include "xlsxnumformatparser_p.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <QDataStream>
 #include <QDebug>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+namespace {
+
+// splitmix64 finalizer
+quint64 mix64(quint64 h)
+{
+    h ^= h >> 30;
+    h *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+    h ^= h >> 27;
+    h *= Q_UINT64_C(0x94d049bb133111eb);
+    h ^= h >> 31;
+    return h;
+}
+
+// FNV-1a over the UTF-16 code units
+quint64 stringHash(const QString &string)
+{
+    quint64 h = Q_UINT64_C(0xcbf29ce484222325);
+    for (const QChar ch : string) {
+        h ^= ch.unicode();
+        h *= Q_UINT64_C(0x100000001b3);
+    }
+    return h;
+}
+
+quint64 colorHash(const XlsxColor &color)
+{
+    if (color.isRgbColor())
+        return mix64(1) ^ color.rgbColor().rgba();
+    if (color.isIndexedColor())
+        return mix64(2) ^ quint64(color.indexedColor());
+    if (color.isThemeColor()) {
+        quint64 h = mix64(3);
+        for (const QString &part : color.themeColor())
+            h = mix64(h ^ stringHash(part));
+        return h;
+    }
+    return 0;
+}
+
+bool sameColor(const XlsxColor &a, const XlsxColor &b)
+{
+    if (a.isRgbColor())
+        return b.isRgbColor() && a.rgbColor().rgba() == b.rgbColor().rgba();
+    if (a.isIndexedColor())
+        return b.isIndexedColor() && a.indexedColor() == b.indexedColor();
+    if (a.isThemeColor())
+        return b.isThemeColor() && a.themeColor() == b.themeColor();
+    return b.isInvalid();
+}
+
+bool entryLess(const FormatPrivate::PropertyEntry &entry, int id)
+{
+    return entry.id < id;
+}
+
+} // namespace
+
 FormatPrivate::FormatPrivate()
     : dirty(true)
     , font_dirty(true)
@@ -29,6 +89,7 @@ FormatPrivate::FormatPrivate()
     , dxf_indexValid(false)
     , theme(0)
 {
+    groupHash.fill(0);
 }
 
 FormatPrivate::FormatPrivate(const FormatPrivate &other)
@@ -54,6 +115,7 @@ FormatPrivate::FormatPrivate(const FormatPrivate &other)
     , dxf_indexValid(other.dxf_indexValid)
     , theme(other.theme)
     , properties(other.properties)
+    , groupHash(other.groupHash)
 {
 }
 
@@ -61,6 +123,109 @@ FormatPrivate::~FormatPrivate()
 {
 }
 
+const QVariant *FormatPrivate::find(int propertyId) const
+{
+    auto it = std::lower_bound(properties.begin(), properties.end(), propertyId, entryLess);
+    if (it == properties.end() || it->id != propertyId)
+        return nullptr;
+    return &it->value;
+}
+
+quint64 FormatPrivate::hash() const
+{
+    quint64 h = 0;
+    for (quint64 groupValue : groupHash)
+        h += groupValue;
+    return h;
+}
+
+FormatPrivate::PropertyGroup FormatPrivate::groupOf(int propertyId)
+{
+    if (propertyId < P_Font_STARTID)
+        return G_NumFmt;
+    if (propertyId < P_Font_ENDID)
+        return G_Font;
+    if (propertyId < P_Border_ENDID)
+        return G_Border;
+    if (propertyId < P_Fill_ENDID)
+        return G_Fill;
+    if (propertyId < P_Alignment_ENDID)
+        return G_Alignment;
+    return G_Protection;
+}
+
+quint64 FormatPrivate::propertyHash(int propertyId, const QVariant &value)
+{
+    const int type = value.userType();
+    quint64 h      = 0;
+    if (type == qMetaTypeId<XlsxColor>()) {
+        h = colorHash(qvariant_cast<XlsxColor>(value));
+    } else {
+        switch (type) {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+            h = quint64(value.toInt());
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float: {
+            const double number = value.toDouble();
+            std::memcpy(&h, &number, sizeof(h));
+            break;
+        }
+        default:
+            h = stringHash(value.toString());
+            break;
+        }
+    }
+    return mix64(h ^ mix64((quint64(propertyId) << 32) | quint32(type)));
+}
+
+bool FormatPrivate::sameValue(const QVariant &a, const QVariant &b)
+{
+    const int type = a.userType();
+    if (type != b.userType())
+        return false;
+
+    if (type == qMetaTypeId<XlsxColor>())
+        return sameColor(qvariant_cast<XlsxColor>(a), qvariant_cast<XlsxColor>(b));
+
+    switch (type) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+        return a.toInt() == b.toInt();
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return a.toDouble() == b.toDouble();
+    case QMetaType::QString:
+        return a.toString() == b.toString();
+    default:
+        return a == b;
+    }
+}
+
+bool FormatPrivate::sameProperties(const FormatPrivate *a,
+                                   const FormatPrivate *b,
+                                   int firstId,
+                                   int endId)
+{
+    static const QVarLengthArray<PropertyEntry, 8> noProperties;
+    const auto &pa = a ? a->properties : noProperties;
+    const auto &pb = b ? b->properties : noProperties;
+
+    auto ia       = std::lower_bound(pa.begin(), pa.end(), firstId, entryLess);
+    auto ib       = std::lower_bound(pb.begin(), pb.end(), firstId, entryLess);
+    const auto ea = std::lower_bound(ia, pa.end(), endId, entryLess);
+    const auto eb = std::lower_bound(ib, pb.end(), endId, entryLess);
+    if (ea - ia != eb - ib)
+        return false;
+
+    for (; ia != ea; ++ia, ++ib) {
+        if (ia->id != ib->id || !sameValue(ia->value, ib->value))
+            return false;
+    }
+    return true;
+}
+
 /*!
  * \class Format
  * \inmodule QtXlsx
@@ -532,11 +697,10 @@ QByteArray Format::fontKey() const
     if (d->font_dirty) {
         QByteArray key;
         QDataStream stream(&key, QIODevice::WriteOnly);
-        for (int i = FormatPrivate::P_Font_STARTID; i < FormatPrivate::P_Font_ENDID; ++i) {
-            auto it = d->properties.constFind(i);
-            if (it != d->properties.constEnd())
-                stream << i << it.value();
-        };
+        for (const FormatPrivate::PropertyEntry &entry : d->properties) {
+            if (entry.id >= FormatPrivate::P_Font_STARTID && entry.id < FormatPrivate::P_Font_ENDID)
+                stream << entry.id << entry.value;
+        }
 
         const_cast<Format *>(this)->d->font_key   = key;
         const_cast<Format *>(this)->d->font_dirty = false;
@@ -545,6 +709,15 @@ QByteArray Format::fontKey() const
     return d->font_key;
 }
 
+/*!
+ * \internal
+ * Structural hash of the font properties, 0 if there are none.
+ */
+quint64 Format::fontHash() const
+{
+    return d ? d->groupHash[FormatPrivate::G_Font] : 0;
+}
+
 /*!
         \internal
         Return true if the format has font format, otherwise return false.
@@ -944,11 +1117,10 @@ QByteArray Format::borderKey() const
     if (d->border_dirty) {
         QByteArray key;
         QDataStream stream(&key, QIODevice::WriteOnly);
-        for (int i = FormatPrivate::P_Border_STARTID; i < FormatPrivate::P_Border_ENDID; ++i) {
-            auto it = d->properties.constFind(i);
-            if (it != d->properties.constEnd())
-                stream << i << it.value();
-        };
+        for (const FormatPrivate::PropertyEntry &entry : d->properties) {
+            if (entry.id >= FormatPrivate::P_Border_STARTID && entry.id < FormatPrivate::P_Border_ENDID)
+                stream << entry.id << entry.value;
+        }
 
         const_cast<Format *>(this)->d->border_key   = key;
         const_cast<Format *>(this)->d->border_dirty = false;
@@ -957,6 +1129,15 @@ QByteArray Format::borderKey() const
     return d->border_key;
 }
 
+/*!
+ * \internal
+ * Structural hash of the border properties, 0 if there are none.
+ */
+quint64 Format::borderHash() const
+{
+    return d ? d->groupHash[FormatPrivate::G_Border] : 0;
+}
+
 /*!
         \internal
         Return true if the format has border format, otherwise return false.
@@ -1065,11 +1246,10 @@ QByteArray Format::fillKey() const
     if (d->fill_dirty) {
         QByteArray key;
         QDataStream stream(&key, QIODevice::WriteOnly);
-        for (int i = FormatPrivate::P_Fill_STARTID; i < FormatPrivate::P_Fill_ENDID; ++i) {
-            auto it = d->properties.constFind(i);
-            if (it != d->properties.constEnd())
-                stream << i << it.value();
-        };
+        for (const FormatPrivate::PropertyEntry &entry : d->properties) {
+            if (entry.id >= FormatPrivate::P_Fill_STARTID && entry.id < FormatPrivate::P_Fill_ENDID)
+                stream << entry.id << entry.value;
+        }
 
         const_cast<Format *>(this)->d->fill_key   = key;
         const_cast<Format *>(this)->d->fill_dirty = false;
@@ -1078,6 +1258,15 @@ QByteArray Format::fillKey() const
     return d->fill_key;
 }
 
+/*!
+ * \internal
+ * Structural hash of the fill properties, 0 if there are none.
+ */
+quint64 Format::fillHash() const
+{
+    return d ? d->groupHash[FormatPrivate::G_Fill] : 0;
+}
+
 /*!
         \internal
         Return true if the format has fill format, otherwise return false.
@@ -1155,11 +1344,8 @@ void Format::mergeFormat(const Format &modifier)
         return;
     }
 
-    QMapIterator<int, QVariant> it(modifier.d->properties);
-    while (it.hasNext()) {
-        it.next();
-        setProperty(it.key(), it.value());
-    }
+    for (const FormatPrivate::PropertyEntry &entry : modifier.d->properties)
+        setProperty(entry.id, entry.value);
 }
 
 /*!
@@ -1194,11 +1380,8 @@ QByteArray Format::formatKey() const
         QByteArray key;
         QDataStream stream(&key, QIODevice::WriteOnly);
 
-        QMapIterator<int, QVariant> i(d->properties);
-        while (i.hasNext()) {
-            i.next();
-            stream << i.key() << i.value();
-        }
+        for (const FormatPrivate::PropertyEntry &entry : d->properties)
+            stream << entry.id << entry.value;
 
         d->formatKey = key;
         d->dirty     = false;
@@ -1207,6 +1390,16 @@ QByteArray Format::formatKey() const
     return d->formatKey;
 }
 
+/*!
+ * \internal
+ * Structural hash of all properties, 0 for an empty format. Equal formats
+ * have equal hashes; Styles deduplicates formats by it.
+ */
+quint64 Format::formatHash() const
+{
+    return d ? d->hash() : 0;
+}
+
 /*!
  * \internal
  *  Called by QXlsx::Styles or some unittests.
@@ -1278,7 +1471,9 @@ bool Format::dxfIndexValid() const
 */
 bool Format::operator==(const Format &format) const
 {
-    return this->formatKey() == format.formatKey();
+    return formatHash() == format.formatHash() &&
+           FormatPrivate::sameProperties(
+               d.constData(), format.d.constData(), FormatPrivate::P_STARTID, FormatPrivate::P_ENDID);
 }
 
 /*!
@@ -1286,7 +1481,7 @@ bool Format::operator==(const Format &format) const
 */
 bool Format::operator!=(const Format &format) const
 {
-    return this->formatKey() != format.formatKey();
+    return !operator==(format);
 }
 
 int Format::theme() const
@@ -1300,9 +1495,8 @@ int Format::theme() const
 QVariant Format::property(int propertyId, const QVariant &defaultValue) const
 {
     if (d) {
-        auto it = d->properties.constFind(propertyId);
-        if (it != d->properties.constEnd())
-            return it.value();
+        if (const QVariant *value = d->find(propertyId))
+            return *value;
     }
     return defaultValue;
 }
@@ -1318,23 +1512,39 @@ void Format::setProperty(int propertyId,
     if (!d)
         d = new FormatPrivate;
 
+    auto it = std::lower_bound(
+        d->properties.constBegin(), d->properties.constEnd(), propertyId, entryLess);
+    const int pos    = int(it - d->properties.constBegin());
+    const bool found = it != d->properties.constEnd() && it->id == propertyId;
+    const FormatPrivate::PropertyGroup group = FormatPrivate::groupOf(propertyId);
+
     if (value != clearValue) {
-        auto it = d->properties.constFind(propertyId);
-        if (it != d->properties.constEnd() && it.value() == value)
+        if (found && FormatPrivate::sameValue(it->value, value))
             return;
 
         if (detach)
             d.detach();
 
-        d->properties[propertyId] = value;
+        // Keep the group hash in step: drop the old value, add the new one
+        if (found) {
+            d->groupHash[group] -= FormatPrivate::propertyHash(propertyId, d->properties[pos].value);
+            d->properties[pos].value = value;
+        } else {
+            FormatPrivate::PropertyEntry entry;
+            entry.id    = propertyId;
+            entry.value = value;
+            d->properties.insert(pos, entry);
+        }
+        d->groupHash[group] += FormatPrivate::propertyHash(propertyId, value);
     } else {
-        if (!d->properties.contains(propertyId))
+        if (!found)
             return;
 
         if (detach)
             d.detach();
 
-        d->properties.remove(propertyId);
+        d->groupHash[group] -= FormatPrivate::propertyHash(propertyId, d->properties[pos].value);
+        d->properties.remove(pos);
     }
 
     d->dirty          = true;
@@ -1370,7 +1580,7 @@ bool Format::hasProperty(int propertyId) const
 {
     if (!d)
         return false;
-    return d->properties.contains(propertyId);
+    return d->find(propertyId) != nullptr;
 }
 
 /*!
@@ -1381,7 +1591,7 @@ bool Format::boolProperty(int propertyId, bool defaultValue) const
     if (!hasProperty(propertyId))
         return defaultValue;
 
-    const QVariant prop = d->properties[propertyId];
+    const QVariant prop = *d->find(propertyId);
     if (prop.userType() != QMetaType::Bool)
         return defaultValue;
     return prop.toBool();
@@ -1395,7 +1605,7 @@ int Format::intProperty(int propertyId, int defaultValue) const
     if (!hasProperty(propertyId))
         return defaultValue;
 
-    const QVariant prop = d->properties[propertyId];
+    const QVariant prop = *d->find(propertyId);
     if (prop.userType() != QMetaType::Int)
         return defaultValue;
     return prop.toInt();
@@ -1409,7 +1619,7 @@ double Format::doubleProperty(int propertyId, double defaultValue) const
     if (!hasProperty(propertyId))
         return defaultValue;
 
-    const QVariant prop = d->properties[propertyId];
+    const QVariant prop = *d->find(propertyId);
     if (prop.userType() != QMetaType::Double && prop.userType() != QMetaType::Float)
         return defaultValue;
     return prop.toDouble();
@@ -1423,7 +1633,7 @@ QString Format::stringProperty(int propertyId, const QString &defaultValue) cons
     if (!hasProperty(propertyId))
         return defaultValue;
 
-    const QVariant prop = d->properties[propertyId];
+    const QVariant prop = *d->find(propertyId);
     if (prop.userType() != QMetaType::QString)
         return defaultValue;
     return prop.toString();
@@ -1437,7 +1647,7 @@ QColor Format::colorProperty(int propertyId, const QColor &defaultValue) const
     if (!hasProperty(propertyId))
         return defaultValue;
 
-    const QVariant prop = d->properties[propertyId];
+    const QVariant prop = *d->find(propertyId);
     if (prop.userType() != qMetaTypeId<XlsxColor>())
         return defaultValue;
     return qvariant_cast<XlsxColor>(prop).rgbColor();
@@ -1446,7 +1656,12 @@ QColor Format::colorProperty(int propertyId, const QColor &defaultValue) const
 #ifndef QT_NO_DEBUG_STREAM
 QDebug operator<<(QDebug dbg, const Format &f)
 {
-    dbg.nospace() << "QXlsx::Format(" << f.d->properties << ")";
+    dbg.nospace() << "QXlsx::Format(";
+    if (f.d) {
+        for (const FormatPrivate::PropertyEntry &entry : f.d->properties)
+            dbg << entry.id << ": " << entry.value << ", ";
+    }
+    dbg << ")";
     return dbg.space();
 }
 #endif
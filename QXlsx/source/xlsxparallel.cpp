@@ -0,0 +1,91 @@
+// xlsxparallel.cpp
+
+#include "xlsxparallel_p.h"
+
+#include <memory>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+struct ParallelState {
+    ParallelState(int count, const std::function<void(int)> &job)
+        : count(count)
+        , job(job)
+    {
+    }
+
+    // Claims and runs jobs until none are left.
+    void work()
+    {
+        int done = 0;
+        for (int i = next.fetchAndAddRelaxed(1); i < count; i = next.fetchAndAddRelaxed(1)) {
+            job(i);
+            ++done;
+        }
+        if (done == 0)
+            return;
+
+        QMutexLocker locker(&mutex);
+        finished += done;
+        if (finished == count)
+            allFinished.wakeAll();
+    }
+
+    const int count;
+    const std::function<void(int)> &job;
+    QAtomicInt next;
+    QMutex mutex;
+    QWaitCondition allFinished;
+    int finished = 0;
+};
+
+class ParallelRunnable : public QRunnable
+{
+public:
+    explicit ParallelRunnable(const std::shared_ptr<ParallelState> &state)
+        : m_state(state)
+    {
+    }
+
+    void run() override { m_state->work(); }
+
+private:
+    std::shared_ptr<ParallelState> m_state;
+};
+
+} // namespace
+
+void parallelFor(int count, const std::function<void(int)> &job)
+{
+    if (count <= 0)
+        return;
+
+    std::shared_ptr<ParallelState> state = std::make_shared<ParallelState>(count, job);
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int helpers = qMin(count, QThread::idealThreadCount()) - 1;
+    for (int i = 0; i < helpers; ++i) {
+        ParallelRunnable *runnable = new ParallelRunnable(state);
+        if (!pool->tryStart(runnable)) {
+            delete runnable;
+            break;
+        }
+    }
+
+    state->work();
+
+    QMutexLocker locker(&state->mutex);
+    while (state->finished < count)
+        state->allFinished.wait(&state->mutex);
+}
+
+QT_END_NAMESPACE_XLSX
@@ -45,7 +45,7 @@ bool parse_cell_ref(const QString& r, int* out_row, int* out_col)
 QStringList load_shared_strings_all(ZipReader& zip)
 {
     QStringList out;
-    const QByteArray xml = zip.fileData(QStringLiteral("xl/sharedStrings.xml"));
+    const QByteArray xml = zip.fileDataView(QStringLiteral("xl/sharedStrings.xml"));
     if (xml.isEmpty())
         return out;
 
@@ -75,13 +75,11 @@ QStringList load_shared_strings_all(ZipReader& zip)
     return out;
 }
 
-bool read_sheet_xml_sax(const QByteArray& sheet_xml,
-                        const sax_options& opt,
-                        const QStringList* shared_strings,
-                        const sax_cell_callback& on_cell)
+static bool read_sheet_xml_sax(QXmlStreamReader& rd,
+                               const sax_options& opt,
+                               const QStringList* shared_strings,
+                               const sax_cell_callback& on_cell)
 {
-    QXmlStreamReader rd(sheet_xml);
-
     bool in_sheetdata = false;
     bool in_c = false;
     bool in_v = false;
@@ -165,4 +163,22 @@ bool read_sheet_xml_sax(const QByteArray& sheet_xml,
     return !rd.hasError();
 }
 
+bool read_sheet_xml_sax(const QByteArray& sheet_xml,
+                        const sax_options& opt,
+                        const QStringList* shared_strings,
+                        const sax_cell_callback& on_cell)
+{
+    QXmlStreamReader rd(sheet_xml);
+    return read_sheet_xml_sax(rd, opt, shared_strings, on_cell);
+}
+
+bool read_sheet_xml_sax(QIODevice* sheet_xml,
+                        const sax_options& opt,
+                        const QStringList* shared_strings,
+                        const sax_cell_callback& on_cell)
+{
+    QXmlStreamReader rd(sheet_xml);
+    return read_sheet_xml_sax(rd, opt, shared_strings, on_cell);
+}
+
 } // namespace QXlsx
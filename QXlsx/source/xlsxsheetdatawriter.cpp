@@ -0,0 +1,187 @@
+// xlsxsheetdatawriter.cpp
+
+#include "xlsxsheetdatawriter_p.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QLocale>
+
+#if defined(__has_include)
+#    if __has_include(<charconv>) &&                                                               \
+        (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#        include <charconv>
+#    endif
+#endif
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const size_t kBufferSize  = 64 * 1024;
+const int kMaxColumn      = 16384; // XFD
+const double kMaxExactInt = 9007199254740992.0; // 2^53
+
+// Column names "A" to "XFD", computed once
+struct ColumnNames {
+    ColumnNames()
+    {
+        for (int column = 1; column <= kMaxColumn; ++column) {
+            char letters[3];
+            int length = 0;
+            for (int n = column; n > 0; n = (n - 1) / 26)
+                letters[length++] = char('A' + (n - 1) % 26);
+            for (int i = 0; i < length; ++i)
+                names[column][i] = letters[length - 1 - i];
+            lengths[column] = quint8(length);
+        }
+    }
+
+    char names[kMaxColumn + 1][3];
+    quint8 lengths[kMaxColumn + 1];
+};
+
+const ColumnNames &columnNames()
+{
+    static const ColumnNames table;
+    return table;
+}
+
+// Writes the decimal digits of \a value ending at \a end, returns the first one
+char *formatUnsigned(quint64 value, char *end)
+{
+    do {
+        *--end = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+} // namespace
+
+SheetDataWriter::SheetDataWriter(QIODevice *device)
+    : m_device(device)
+    , m_buffer(kBufferSize)
+{
+    columnNames();
+}
+
+SheetDataWriter::~SheetDataWriter()
+{
+    flush();
+}
+
+void SheetDataWriter::flush()
+{
+    if (m_used == 0)
+        return;
+    writeToDevice(m_buffer.data(), m_used);
+    m_used = 0;
+}
+
+void SheetDataWriter::writeToDevice(const char *data, size_t size)
+{
+    if (!m_error && m_device->write(data, qint64(size)) != qint64(size))
+        m_error = true;
+}
+
+void SheetDataWriter::writeInt(qint64 value)
+{
+    char digits[24];
+    char *end   = digits + sizeof(digits);
+    char *begin = formatUnsigned(value < 0 ? 0 - quint64(value) : quint64(value), end);
+    if (value < 0)
+        *--begin = '-';
+    writeRaw(begin, size_t(end - begin));
+}
+
+/*!
+  Writes the shortest representation of \a value that reads back as the
+  same double. Integral values, the common case, skip the general
+  conversion.
+ */
+void SheetDataWriter::writeDouble(double value)
+{
+    if (value == std::floor(value) && std::fabs(value) < kMaxExactInt) {
+        writeInt(qint64(value));
+        return;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    char digits[32];
+    const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    writeRaw(digits, size_t(result.ptr - digits));
+#else
+    const QByteArray digits = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+    writeRaw(digits.constData(), size_t(digits.size()));
+#endif
+}
+
+void SheetDataWriter::writeCellReference(int row, int column)
+{
+    const ColumnNames &table = columnNames();
+    writeRaw(table.names[column], table.lengths[column]);
+    writeInt(row);
+}
+
+/*!
+  Writes \a text as UTF-8 with '&', '<' and '>' escaped, like
+  QXmlStreamWriter::writeCharacters(). Carriage returns are written as a
+  character reference so they survive parsing, and control characters
+  that XML 1.0 cannot represent are dropped.
+ */
+void SheetDataWriter::writeEscaped(const QString &text)
+{
+    const ushort *p   = text.utf16();
+    const ushort *end = p + text.size();
+    while (p != end) {
+        // Runs of plain ASCII are copied in one go
+        const ushort *run      = p;
+        const ushort *runLimit = end - p > std::ptrdiff_t(kBufferSize) ? p + kBufferSize : end;
+        while (p != runLimit && *p < 0x80 && *p >= 0x20 && *p != '&' && *p != '<' && *p != '>')
+            ++p;
+        if (p != run) {
+            char *out = reserve(size_t(p - run));
+            for (; run != p; ++run)
+                *out++ = char(*run);
+            continue;
+        }
+
+        const uint c = *p++;
+        if (c == '&') {
+            writeLiteral("&amp;");
+        } else if (c == '<') {
+            writeLiteral("&lt;");
+        } else if (c == '>') {
+            writeLiteral("&gt;");
+        } else if (c == '\r') {
+            writeLiteral("&#13;");
+        } else if (c < 0x20) {
+            if (c == '\t' || c == '\n') {
+                *reserve(1) = char(c);
+            }
+        } else if (c < 0x800) {
+            char *out = reserve(2);
+            out[0]    = char(0xc0 | (c >> 6));
+            out[1]    = char(0x80 | (c & 0x3f));
+        } else if (QChar::isHighSurrogate(c) && p != end && QChar::isLowSurrogate(*p)) {
+            const uint ucs4 = QChar::surrogateToUcs4(ushort(c), *p++);
+            char *out       = reserve(4);
+            out[0]          = char(0xf0 | (ucs4 >> 18));
+            out[1]          = char(0x80 | ((ucs4 >> 12) & 0x3f));
+            out[2]          = char(0x80 | ((ucs4 >> 6) & 0x3f));
+            out[3]          = char(0x80 | (ucs4 & 0x3f));
+        } else {
+            // Unpaired surrogates become U+FFFD, as QString::toUtf8() does
+            const uint ucs4 = QChar::isSurrogate(c) ? 0xfffd : c;
+            char *out       = reserve(3);
+            out[0]          = char(0xe0 | (ucs4 >> 12));
+            out[1]          = char(0x80 | ((ucs4 >> 6) & 0x3f));
+            out[2]          = char(0x80 | (ucs4 & 0x3f));
+        }
+    }
+}
+
+QT_END_NAMESPACE_XLSX
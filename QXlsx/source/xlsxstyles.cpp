@@ -64,7 +64,7 @@ Styles::Styles(CreateFlag flag)
         Format fillFmt;
         fillFmt.setFillPattern(Format::PatternGray125);
         m_fillsList.append(fillFmt);
-        m_fillsHash.insert(fillFmt.fillKey(), fillFmt);
+        m_fillsHash.insert(fillFmt.fillHash(), fillFmt);
     }
 }
 
@@ -72,6 +72,30 @@ Styles::~Styles()
 {
 }
 
+Styles::FormatHash::iterator
+    Styles::findFormat(FormatHash &hash, quint64 key, const Format &format, int firstId, int endId)
+{
+    for (auto it = hash.find(key); it != hash.end() && it.key() == key; ++it) {
+        if (FormatPrivate::sameProperties(
+                it->d.constData(), format.d.constData(), firstId, endId))
+            return it;
+    }
+    return hash.end();
+}
+
+void Styles::insertFormat(FormatHash &hash,
+                          quint64 key,
+                          const Format &format,
+                          int firstId,
+                          int endId)
+{
+    auto it = findFormat(hash, key, format, firstId, endId);
+    if (it != hash.end())
+        *it = format;
+    else
+        hash.insert(key, format);
+}
+
 Format Styles::xfFormat(int idx) const
 {
     if (idx < 0 || idx >= m_xf_formatsList.size())
@@ -218,62 +242,81 @@ void Styles::addXfFormat(const Format &format, bool force)
     }
 
     // Font
-    const auto &fontIt = m_fontsHash.constFind(format.fontKey());
+    const auto fontIt = findFormat(m_fontsHash,
+                                   format.fontHash(),
+                                   format,
+                                   FormatPrivate::P_Font_STARTID,
+                                   FormatPrivate::P_Font_ENDID);
     if (format.hasFontData() && !format.fontIndexValid()) {
         // Assign proper font index, if has font data.
-        if (fontIt == m_fontsHash.constEnd())
+        if (fontIt == m_fontsHash.end())
             const_cast<Format *>(&format)->setFontIndex(m_fontsList.size());
         else
             const_cast<Format *>(&format)->setFontIndex(fontIt->fontIndex());
     }
-    if (fontIt == m_fontsHash.constEnd()) {
+    if (fontIt == m_fontsHash.end()) {
         // Still a valid font if the format has no fontData. (All font properties are default)
         m_fontsList.append(format);
-        m_fontsHash[format.fontKey()] = format;
+        m_fontsHash.insert(format.fontHash(), format);
     }
 
     // Fill
-    const auto &fillIt = m_fillsHash.constFind(format.fillKey());
+    const auto fillIt = findFormat(m_fillsHash,
+                                   format.fillHash(),
+                                   format,
+                                   FormatPrivate::P_Fill_STARTID,
+                                   FormatPrivate::P_Fill_ENDID);
     if (format.hasFillData() && !format.fillIndexValid()) {
         // Assign proper fill index, if has fill data.
-        if (fillIt == m_fillsHash.constEnd())
+        if (fillIt == m_fillsHash.end())
             const_cast<Format *>(&format)->setFillIndex(m_fillsList.size());
         else
             const_cast<Format *>(&format)->setFillIndex(fillIt->fillIndex());
     }
-    if (fillIt == m_fillsHash.constEnd()) {
+    if (fillIt == m_fillsHash.end()) {
         // Still a valid fill if the format has no fillData. (All fill properties are default)
         m_fillsList.append(format);
-        m_fillsHash[format.fillKey()] = format;
+        m_fillsHash.insert(format.fillHash(), format);
     }
 
     // Border
-    const auto &borderIt = m_bordersHash.constFind(format.borderKey());
+    const auto borderIt = findFormat(m_bordersHash,
+                                     format.borderHash(),
+                                     format,
+                                     FormatPrivate::P_Border_STARTID,
+                                     FormatPrivate::P_Border_ENDID);
     if (format.hasBorderData() && !format.borderIndexValid()) {
         // Assign proper border index, if has border data.
-        if (borderIt == m_bordersHash.constEnd())
+        if (borderIt == m_bordersHash.end())
             const_cast<Format *>(&format)->setBorderIndex(m_bordersList.size());
         else
             const_cast<Format *>(&format)->setBorderIndex(borderIt->borderIndex());
     }
-    if (borderIt == m_bordersHash.constEnd()) {
+    if (borderIt == m_bordersHash.end()) {
         // Still a valid border if the format has no borderData. (All border properties are default)
         m_bordersList.append(format);
-        m_bordersHash[format.borderKey()] = format;
+        m_bordersHash.insert(format.borderHash(), format);
     }
 
     // Format
-    const auto &formatIt = m_xf_formatsHash.constFind(format.formatKey());
+    const auto formatIt = findFormat(m_xf_formatsHash,
+                                     format.formatHash(),
+                                     format,
+                                     FormatPrivate::P_STARTID,
+                                     FormatPrivate::P_ENDID);
     if (!format.isEmpty() && !format.xfIndexValid()) {
-        if (formatIt == m_xf_formatsHash.constEnd())
+        if (formatIt == m_xf_formatsHash.end())
             const_cast<Format *>(&format)->setXfIndex(m_xf_formatsList.size());
         else
             const_cast<Format *>(&format)->setXfIndex(formatIt->xfIndex());
     }
 
-    if (formatIt == m_xf_formatsHash.constEnd() || force) {
+    if (formatIt == m_xf_formatsHash.end()) {
         m_xf_formatsList.append(format);
-        m_xf_formatsHash[format.formatKey()] = format;
+        m_xf_formatsHash.insert(format.formatHash(), format);
+    } else if (force) {
+        m_xf_formatsList.append(format);
+        *formatIt = format;
     }
 }
 
@@ -284,9 +327,13 @@ void Styles::addDxfFormat(const Format &format, bool force)
         fixNumFmt(format);
     }
 
-    const auto &formatIt = m_dxf_formatsHash.constFind(format.formatKey());
+    const auto formatIt = findFormat(m_dxf_formatsHash,
+                                     format.formatHash(),
+                                     format,
+                                     FormatPrivate::P_STARTID,
+                                     FormatPrivate::P_ENDID);
     if (!format.isEmpty() && !format.dxfIndexValid()) {
-        if (formatIt == m_dxf_formatsHash.constEnd()) // m_xf_formatsHash.constEnd()) // issue #108
+        if (formatIt == m_dxf_formatsHash.end()) // m_xf_formatsHash.constEnd()) // issue #108
         {
             const_cast<Format *>(&format)->setDxfIndex(m_dxf_formatsList.size());
         } else {
@@ -294,9 +341,12 @@ void Styles::addDxfFormat(const Format &format, bool force)
         }
     }
 
-    if (formatIt == m_dxf_formatsHash.constEnd() || force) {
+    if (formatIt == m_dxf_formatsHash.end()) {
+        m_dxf_formatsList.append(format);
+        m_dxf_formatsHash.insert(format.formatHash(), format);
+    } else if (force) {
         m_dxf_formatsList.append(format);
-        m_dxf_formatsHash[format.formatKey()] = format;
+        *formatIt = format;
     }
 }
 
@@ -835,7 +885,11 @@ bool Styles::readFonts(QXmlStreamReader &reader)
                 Format format;
                 readFont(reader, format);
                 m_fontsList.append(format);
-                m_fontsHash.insert(format.fontKey(), format);
+                insertFormat(m_fontsHash,
+                             format.fontHash(),
+                             format,
+                             FormatPrivate::P_Font_STARTID,
+                             FormatPrivate::P_Font_ENDID);
                 if (format.isValid())
                     format.setFontIndex(m_fontsList.size() - 1);
             }
@@ -961,7 +1015,11 @@ bool Styles::readFills(QXmlStreamReader &reader)
                 Format fill;
                 readFill(reader, fill);
                 m_fillsList.append(fill);
-                m_fillsHash.insert(fill.fillKey(), fill);
+                insertFormat(m_fillsHash,
+                             fill.fillHash(),
+                             fill,
+                             FormatPrivate::P_Fill_STARTID,
+                             FormatPrivate::P_Fill_ENDID);
                 if (fill.isValid())
                     fill.setFillIndex(m_fillsList.size() - 1);
             }
@@ -1060,7 +1118,11 @@ bool Styles::readBorders(QXmlStreamReader &reader)
                 Format border;
                 readBorder(reader, border);
                 m_bordersList.append(border);
-                m_bordersHash.insert(border.borderKey(), border);
+                insertFormat(m_bordersHash,
+                             border.borderHash(),
+                             border,
+                             FormatPrivate::P_Border_STARTID,
+                             FormatPrivate::P_Border_ENDID);
                 if (border.isValid())
                     border.setBorderIndex(m_bordersList.size() - 1);
             }
@@ -192,6 +192,186 @@ QString unescapeSheetName(const QString &sheetName)
     return name;
 }
 
+namespace {
+
+// Powers of ten that are exactly representable as doubles
+const double kExactPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+const quint64 kMaxExactMantissa = quint64(1) << 53;
+
+bool isAsciiDigit(ushort c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool matchesAt(const ushort *data, int size, int pos, const char *latin1, int length)
+{
+    if (pos < 0 || pos + length > size)
+        return false;
+    for (int i = 0; i < length; ++i) {
+        if (data[pos + i] != ushort(latin1[i]))
+            return false;
+    }
+    return true;
+}
+
+/*
+  Same result as matching "^([fh]tt?ps?://)|(mailto:)|(file://)". Every
+  alternative contains a colon, so strings without one are rejected by a
+  single vectorized QString::indexOf() scan.
+ */
+bool looksLikeUrl(const QString &string)
+{
+    int colon = string.indexOf(QLatin1Char(':'));
+    if (colon < 0)
+        return false;
+
+    const ushort *data = string.utf16();
+    const int size     = int(string.size());
+
+    // [fh]tt?ps?:// at the start; the optional letters never need backtracking
+    if (data[0] == 'f' || data[0] == 'h') {
+        int i = 1;
+        if (i < size && data[i] == 't') {
+            ++i;
+            if (i < size && data[i] == 't')
+                ++i;
+            if (i < size && data[i] == 'p') {
+                ++i;
+                if (i < size && data[i] == 's')
+                    ++i;
+                if (matchesAt(data, size, i, "://", 3))
+                    return true;
+            }
+        }
+    }
+
+    // mailto: and file:// may appear anywhere
+    while (colon >= 0) {
+        if (matchesAt(data, size, colon - 6, "mailto:", 7) ||
+            matchesAt(data, size, colon - 4, "file://", 7))
+            return true;
+        colon = string.indexOf(QLatin1Char(':'), colon + 1);
+    }
+    return false;
+}
+
+/*
+  Parses \a string the way QString::toDouble() does. Plain decimal numbers
+  whose digits fit in 53 bits and whose exponent is small are converted
+  exactly here; anything else that might still be a number, such as long
+  mantissas, large exponents, "inf" or "nan", is left to QString::toDouble().
+ */
+bool parseNumber(const QString &string, double *number)
+{
+    const ushort *p   = string.utf16();
+    const ushort *end = p + string.size();
+    while (p != end && QChar::isSpace(*p))
+        ++p;
+    while (end != p && QChar::isSpace(end[-1]))
+        --end;
+    if (p == end)
+        return false;
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p != end && (*p == 'i' || *p == 'I' || *p == 'n' || *p == 'N')) {
+        bool ok = false;
+        *number = string.toDouble(&ok);
+        return ok;
+    }
+
+    quint64 mantissa = 0;
+    int exponent     = 0;
+    int digits       = 0;
+    bool exact       = true;
+    auto addDigit    = [&](ushort c) {
+        mantissa = mantissa * 10 + (c - '0');
+        if (mantissa > kMaxExactMantissa)
+            exact = false;
+    };
+
+    for (; p != end && isAsciiDigit(*p); ++p, ++digits) {
+        if (exact)
+            addDigit(*p);
+    }
+    if (p != end && *p == '.') {
+        for (++p; p != end && isAsciiDigit(*p); ++p, ++digits) {
+            if (exact) {
+                addDigit(*p);
+                --exponent;
+            }
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p == end || !isAsciiDigit(*p))
+            return false;
+        int value = 0;
+        for (; p != end && isAsciiDigit(*p); ++p) {
+            if (value < 100000)
+                value = value * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -value : value;
+    }
+    if (p != end)
+        return false;
+
+    if (!exact || exponent < -22 || exponent > 22) {
+        bool ok = false;
+        *number = string.toDouble(&ok);
+        return ok;
+    }
+
+    // Both operands are exact, so the single multiplication or division
+    // rounds correctly
+    double value = double(mantissa);
+    if (exponent < 0)
+        value /= kExactPowersOfTen[-exponent];
+    else
+        value *= kExactPowersOfTen[exponent];
+    *number = negative ? -value : value;
+    return true;
+}
+
+} // namespace
+
+/*
+ * Decide what Worksheet::write() turns the string \a string into, in one
+ * scan and without allocating: a formula if it starts with '=', a
+ * hyperlink if \a detectHyperlinks is set and it looks like a URL, a
+ * number if \a detectNumbers is set and it parses as one, and plain text
+ * otherwise. For numbers the parsed value is stored in \a number.
+ */
+CellStringKind classifyCellString(const QString &string,
+                                  bool detectHyperlinks,
+                                  bool detectNumbers,
+                                  double *number)
+{
+    if (string.isEmpty())
+        return CellStringKind::Text;
+    if (string.at(0) == QLatin1Char('='))
+        return CellStringKind::Formula;
+    if (detectHyperlinks && looksLikeUrl(string))
+        return CellStringKind::Hyperlink;
+    if (detectNumbers && parseNumber(string, number))
+        return CellStringKind::Number;
+    return CellStringKind::Text;
+}
+
 /*
  * whether the string s starts or ends with space
  */
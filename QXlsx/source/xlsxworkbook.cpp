@@ -750,4 +750,20 @@ bool Workbook::writeDatesAsText() const
     return d->writeDatesAsText;
 }
 
+/*!
+ * Adds \a format to the workbook styles and returns its handle, which the
+ * Worksheet write overloads taking an int style accept. Writing through a
+ * handle skips the per-cell format copy and style lookup, so register each
+ * format once outside of write loops. The same format always gets the same
+ * handle. An empty format returns -1 (Worksheet::KeepCellStyle), which
+ * keeps the style the cell already has; Worksheet::ClearCellStyle writes
+ * cells without a format of their own.
+ */
+int Workbook::registerStyle(const Format &format)
+{
+    Q_D(Workbook);
+    d->styles->addXfFormat(format);
+    return format.isEmpty() ? -1 : format.xfIndex();
+}
+
 QT_END_NAMESPACE_XLSX
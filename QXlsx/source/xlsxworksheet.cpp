@@ -17,11 +17,13 @@
 #include "xlsxformat_p.h"
 #include "xlsxrichstring.h"
 #include "xlsxsharedstrings_p.h"
+#include "xlsxsheetdatawriter_p.h"
 #include "xlsxstyles_p.h"
 #include "xlsxutility_p.h"
 #include "xlsxworkbook.h"
 #include "xlsxworksheet_p.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <QBuffer>
@@ -36,6 +38,7 @@
 #include <QTextDocument>
 #include <QTime>
 #include <QUrl>
+#include <QVarLengthArray>
 #include <QVariant>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -52,6 +55,62 @@ namespace {
 const int XLSX_ROW_MAX    = 1048576;
 const int XLSX_COLUMN_MAX = 16384;
 const int XLSX_STRING_MAX = 32767;
+
+// xf index stored with a cell, -1 leaves the style to its row or column
+qint32 cellStyleIndex(const Format &format)
+{
+    return format.isEmpty() ? -1 : format.xfIndex();
+}
+
+bool isNumericValue(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Cells written by the batch writers, which never carry extras
+CellData blankCell(qint32 style)
+{
+    CellData cell;
+    cell.type  = Cell::NumberType;
+    cell.style = style;
+    return cell;
+}
+
+CellData numberCell(double value, qint32 style)
+{
+    CellData cell = blankCell(style);
+    cell.number   = value;
+    cell.flags    = CellData::HasValue;
+    return cell;
+}
+
+CellData boolCell(bool value, qint32 style)
+{
+    CellData cell;
+    cell.type    = Cell::BooleanType;
+    cell.style   = style;
+    cell.boolean = value;
+    return cell;
+}
+
+CellData sharedStringCell(int sstIndex, qint32 style)
+{
+    CellData cell;
+    cell.type  = Cell::SharedStringType;
+    cell.style = style;
+    cell.index = sstIndex;
+    return cell;
+}
 } // namespace
 
 WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
@@ -66,7 +125,6 @@ WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
     , showRuler(false)
     , showOutlineSymbols(true)
     , showWhiteSpace(true)
-    , urlPattern(QStringLiteral("^([fh]tt?ps?://)|(mailto:)|(file://)"))
 {
 }
 
@@ -74,61 +132,6 @@ WorksheetPrivate::~WorksheetPrivate()
 {
 }
 
-/*
-  Calculate the "spans" attribute of the <row> tag. This is an
-  XLSX optimisation and isn't strictly required. However, it
-  makes comparing files easier. The span is the same for each
-  block of 16 rows.
- */
-void WorksheetPrivate::calculateSpans() const
-{
-    row_spans.clear();
-    int span_min = XLSX_COLUMN_MAX + 1;
-    int span_max = -1;
-
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-            if (cellTable.contains(row_num, col_num)) {
-                if (span_max == -1) {
-                    span_min = col_num;
-                    span_max = col_num;
-                } else {
-                    if (col_num < span_min)
-                        span_min = col_num;
-                    else if (col_num > span_max)
-                        span_max = col_num;
-                }
-            }
-        }
-
-        auto cIt = comments.constFind(row_num);
-        if (cIt != comments.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (cIt->contains(col_num)) {
-                    if (span_max == -1) {
-                        span_min = col_num;
-                        span_max = col_num;
-                    } else {
-                        if (col_num < span_min)
-                            span_min = col_num;
-                        else if (col_num > span_max)
-                            span_max = col_num;
-                    }
-                }
-            }
-        }
-
-        if (row_num % 16 == 0 || row_num == dimension.lastRow()) {
-            if (span_max != -1) {
-                row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-                span_min                = XLSX_COLUMN_MAX + 1;
-                span_max                = -1;
-            }
-        }
-    }
-}
-
 QString WorksheetPrivate::generateDimensionString() const
 {
     if (!dimension.isValid())
@@ -168,12 +171,39 @@ int WorksheetPrivate::checkDimensions(int row, int col, bool ignore_row, bool ig
     return 0;
 }
 
+/*
+  Same as checkDimensions() for every cell of \a range, but the range is
+  validated and the dimension is updated only once.
+*/
+int WorksheetPrivate::checkDimensions(const CellRange &range)
+{
+    if (range.firstRow() < 1 || range.lastRow() > XLSX_ROW_MAX || range.firstColumn() < 1 ||
+        range.lastColumn() > XLSX_COLUMN_MAX || range.firstRow() > range.lastRow() ||
+        range.firstColumn() > range.lastColumn())
+        return -1;
+
+    checkDimensions(range.firstRow(), range.firstColumn());
+    checkDimensions(range.lastRow(), range.lastColumn());
+    return 0;
+}
+
 /*!
   \class Worksheet
   \inmodule QtXlsx
   \brief Represent one worksheet in the workbook.
 */
 
+/*!
+  \enum Worksheet::CellStyle
+
+  Special values for the style handle taken by the write overloads with an
+  int style, next to the handles returned by Workbook::registerStyle().
+
+  \value KeepCellStyle The cell keeps the style it already has, as with an
+         empty Format passed to the Format overloads.
+  \value ClearCellStyle The cell is written without a style of its own.
+*/
+
 /*!
  * \internal
  */
@@ -198,30 +228,18 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
 
     sheet_d->dimension = d->dimension;
 
-    for (auto it = d->cellTable.cells.begin(); it != d->cellTable.cells.end(); ++it) {
-        int row = it.key();
-        for (auto it2 = it.value().begin(); it2 != it.value().end(); ++it2) {
-            int col = it2.key();
-
-            auto cell           = std::make_shared<Cell>(it2.value().get());
-            cell->d_ptr->parent = sheet;
-
-            if (cell->cellType() == Cell::SharedStringType)
-                d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
-
-            sheet_d->cellTable.setValue(row, col, cell);
+    d->cellTable.forEachCell([&](int row, int col, const CellData &source) {
+        CellData cell = source;
+        if (source.flags & CellData::HasExtra) {
+            const CellExtra &extra = d->cellTable.extraAt(source.index);
+            cell.index             = sheet_d->cellTable.addExtra(extra.value, extra.formula);
         }
-    }
 
-    // for (auto it = d->cellTable.cells.begin(); it != d->cellTable.cells.end(); ++it) {
-    //     auto cell           = std::make_shared<Cell>(it.value().get());
-    //     cell->d_ptr->parent = sheet;
+        if (source.type == Cell::SharedStringType)
+            d->sharedStrings()->incRefByStringIndex(d->storedValue(source).toInt());
 
-    //     if (cell->cellType() == Cell::SharedStringType)
-    //         d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
-
-    //     sheet_d->cellTable.setValue(CellTable::row(it.key()), CellTable::column(it.key()), cell);
-    // }
+        sheet_d->cellTable.setValue(row, col, cell);
+    });
 
     sheet_d->merges = d->merges;
     //    sheet_d->rowsInfo = d->rowsInfo;
@@ -440,20 +458,28 @@ bool Worksheet::write(int row, int column, const QVariant &value, const Format &
     } else if (value.userType() == QMetaType::QString) {
         // String
         QString token = value.toString();
-        bool ok;
+        double number = 0;
 
-        if (token.startsWith(QLatin1String("="))) {
+        switch (classifyCellString(token,
+                                   d->workbook->isStringsToHyperlinksEnabled(),
+                                   d->workbook->isStringsToNumbersEnabled(),
+                                   &number)) {
+        case CellStringKind::Formula:
             // convert to formula
             ret = writeFormula(row, column, CellFormula(token), format);
-        } else if (d->workbook->isStringsToHyperlinksEnabled() && token.contains(d->urlPattern)) {
+            break;
+        case CellStringKind::Hyperlink:
             // convert to url
             ret = writeHyperlink(row, column, QUrl(token));
-        } else if (d->workbook->isStringsToNumbersEnabled() && (value.toDouble(&ok), ok)) {
+            break;
+        case CellStringKind::Number:
             // Try convert string to number if the flag enabled.
-            ret = writeNumeric(row, column, value.toDouble(), format);
-        } else {
+            ret = writeNumeric(row, column, number, format);
+            break;
+        default:
             // normal string now
             ret = writeString(row, column, token, format);
+            break;
         }
     } else if (value.userType() == qMetaTypeId<RichString>()) {
         ret = writeString(row, column, value.value<RichString>(), format);
@@ -571,19 +597,168 @@ std::shared_ptr<Cell> Worksheet::cellAt(const CellReference &row_column) const
 std::shared_ptr<Cell> Worksheet::cellAt(int row, int col) const
 {
     Q_D(const Worksheet);
-    return d->cellTable.cellAt(row, col);
+    const CellData *cell = d->cellTable.cellAt(row, col);
+    if (!cell)
+        return {};
+
+    return d->createCell(*cell);
 }
 
 Format WorksheetPrivate::cellFormat(int row, int col) const
 {
-    auto cell = cellTable.cellAt(row, col);
-    if (cell) {
-        return cell->format();
-    }
+    const CellData *cell = cellTable.cellAt(row, col);
+    if (cell && cell->style >= 0)
+        return workbook->styles()->xfFormat(cell->style);
 
     return {};
 }
 
+/*!
+  \internal
+  Returns the xf index to store for the cell (\a row, \a col) when it is
+  written with the style handle \a style: a registered handle is used as
+  is, Worksheet::ClearCellStyle stores none and any other negative handle
+  keeps the style the cell already has.
+ */
+qint32 WorksheetPrivate::cellStyle(int row, int col, int style) const
+{
+    return cellStyle(style >= 0 ? nullptr : cellTable.findRow(row), col, style);
+}
+
+/*!
+  \internal
+  \overload
+  Resolves \a style for the cell in column \a col of \a row, which is
+  null if the row holds no cells, so row writers look the row up once.
+ */
+qint32 WorksheetPrivate::cellStyle(const CellTable::Row *row, int col, int style)
+{
+    if (style >= 0)
+        return style;
+    if (style == Worksheet::ClearCellStyle || !row)
+        return -1;
+
+    const CellData *cell = row->cellAt(col);
+    return cell ? cell->style : -1;
+}
+
+/*!
+  \internal
+  Packs a cell into the cell table. \a value is the stored value, which
+  for shared string cells is the index of the string.
+ */
+void WorksheetPrivate::setCell(int row,
+                               int column,
+                               Cell::CellType type,
+                               const QVariant &value,
+                               qint32 style,
+                               const CellFormula &formula)
+{
+    CellData cell;
+    cell.type  = quint8(type);
+    cell.style = style;
+
+    bool inlined = !formula.isValid();
+    if (inlined) {
+        switch (type) {
+        case Cell::SharedStringType:
+            cell.index = value.toInt();
+            break;
+        case Cell::BooleanType:
+            cell.boolean = value.toBool();
+            break;
+        case Cell::NumberType:
+        case Cell::DateType:
+        case Cell::CustomType:
+            // Note: an invalid value means blank.
+            if (isNumericValue(value)) {
+                cell.number = value.toDouble();
+                cell.flags |= CellData::HasValue;
+            } else if (value.isValid()) {
+                inlined = false;
+            }
+            break;
+        default:
+            inlined = false;
+            break;
+        }
+    }
+
+    if (!inlined) {
+        cell.index = cellTable.addExtra(value, formula);
+        cell.flags |= CellData::HasExtra;
+    }
+    cellTable.setValue(row, column, cell);
+}
+
+QVariant WorksheetPrivate::storedValue(const CellData &cell) const
+{
+    if (cell.flags & CellData::HasExtra)
+        return cellTable.extraAt(cell.index).value;
+
+    switch (cell.type) {
+    case Cell::SharedStringType:
+        return cell.index;
+    case Cell::BooleanType:
+        return cell.boolean;
+    default:
+        if (cell.flags & CellData::HasValue)
+            return cell.number;
+        return {};
+    }
+}
+
+/*
+  Style handles used for dates and times that are written without one,
+  matching the formats writeDateTime() and writeTime() fall back to.
+ */
+qint32 WorksheetPrivate::defaultDateStyle() const
+{
+    Format format;
+    format.setNumberFormat(workbook->defaultDateFormat());
+    return workbook->registerStyle(format);
+}
+
+qint32 WorksheetPrivate::defaultTimeStyle() const
+{
+    Format format;
+    format.setNumberFormat(QStringLiteral("hh:mm:ss"));
+    return workbook->registerStyle(format);
+}
+
+/*!
+  \internal
+  Builds a Cell object for \a cell. Cells are stored packed and only
+  materialized when the public API hands one out.
+ */
+std::shared_ptr<Cell> WorksheetPrivate::createCell(const CellData &cell) const
+{
+    Q_Q(const Worksheet);
+
+    QVariant value = storedValue(cell);
+    RichString richString;
+    if (cell.type == Cell::SharedStringType) {
+        const RichString rs = sharedStrings()->getSharedString(value.toInt());
+        value               = rs.toPlainString();
+        if (rs.isRichString())
+            richString = rs;
+    } else if (value.userType() == qMetaTypeId<RichString>()) {
+        // Inline strings may carry their rich text
+        const RichString rs = value.value<RichString>();
+        value               = rs.toPlainString();
+        if (rs.isRichString())
+            richString = rs;
+    }
+
+    const Format format = cell.style >= 0 ? workbook->styles()->xfFormat(cell.style) : Format();
+    auto ret            = std::make_shared<Cell>(
+        value, Cell::CellType(cell.type), format, const_cast<Worksheet *>(q), cell.style);
+    ret->d_ptr->richString = richString;
+    if (cell.flags & CellData::HasExtra)
+        ret->d_ptr->formula = cellTable.extraAt(cell.index).formula;
+    return ret;
+}
+
 /*!
   \overload
   Write string \a value to the cell \a row_column with the \a format.
@@ -616,14 +791,12 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
     //        error = -2;
     //    }
 
-    d->sharedStrings()->addSharedString(value);
-    Format fmt = format.isValid() ? format : d->cellFormat(row, column);
+    const int sstIndex = d->sharedStrings()->addSharedString(value);
+    Format fmt         = format.isValid() ? format : d->cellFormat(row, column);
     if (value.fragmentCount() == 1 && value.fragmentFormat(0).isValid())
         fmt.mergeFormat(value.fragmentFormat(0));
     d->workbook->styles()->addXfFormat(fmt);
-    auto cell = std::make_shared<Cell>(value.toPlainString(), Cell::SharedStringType, fmt, this);
-    cell->d_ptr->richString = value;
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::SharedStringType, sstIndex, cellStyleIndex(fmt));
     return true;
 }
 
@@ -662,6 +835,33 @@ bool Worksheet::writeString(int row, int column, const QString &value, const For
     return writeString(row, column, rs, format);
 }
 
+/*!
+        \overload
+
+        Write string \a value to the cell (\a row, \a column) with the style
+        handle \a style returned by Workbook::registerStyle().
+        Returns true on success.
+*/
+bool Worksheet::writeString(int row, int column, const QString &value, int style)
+{
+    Q_D(Worksheet);
+    if (d->checkDimensions(row, column))
+        return false;
+
+    const qint32 cellStyle = d->cellStyle(row, column, style);
+    if (d->workbook->isHtmlToRichStringEnabled() && Qt::mightBeRichText(value)) {
+        // The Format overload keeps the current style for an empty format,
+        // so a cleared style is dropped from the cell first
+        if (cellStyle < 0)
+            d->setCell(row, column, Cell::NumberType, QVariant{}, -1);
+        return writeString(row, column, value, d->workbook->styles()->xfFormat(cellStyle));
+    }
+
+    const int sstIndex = d->sharedStrings()->addSharedString(value);
+    d->setCell(row, column, Cell::SharedStringType, sstIndex, cellStyle);
+    return true;
+}
+
 /*!
         \overload
         Write string \a value to the cell \a row_column with the \a format
@@ -695,8 +895,26 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    auto cell = std::make_shared<Cell>(content, Cell::InlineStringType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::InlineStringType, content, cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write string \a value to the cell (\a row, \a column) with the style
+        handle \a style returned by Workbook::registerStyle().
+        Returns true on success.
+*/
+bool Worksheet::writeInlineString(int row, int column, const QString &value, int style)
+{
+    Q_D(Worksheet);
+    if (d->checkDimensions(row, column))
+        return false;
+
+    const QString content = value.size() > XLSX_STRING_MAX ? value.left(XLSX_STRING_MAX) : value;
+    d->setCell(row, column, Cell::InlineStringType, content, d->cellStyle(row, column, style));
 
     return true;
 }
@@ -726,8 +944,25 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::NumberType, value, cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write numeric \a value to the cell (\a row, \a column) with the style
+        handle \a style returned by Workbook::registerStyle().
+        Returns true on success.
+*/
+bool Worksheet::writeNumeric(int row, int column, double value, int style)
+{
+    Q_D(Worksheet);
+    if (d->checkDimensions(row, column))
+        return false;
+
+    d->setCell(row, column, Cell::NumberType, value, d->cellStyle(row, column, style));
 
     return true;
 }
@@ -749,12 +984,12 @@ bool Worksheet::writeFormula(const CellReference &row_column,
 }
 
 /*!
-        Write \a formula_ to the cell (\a row, \a column) with the \a format and \a result.
+        Write \a formula to the cell (\a row, \a column) with the \a format and \a result.
         Returns true on success.
 */
 bool Worksheet::writeFormula(int row,
                              int column,
-                             const CellFormula &formula_,
+                             const CellFormula &formula,
                              const Format &format,
                              double result)
 {
@@ -766,6 +1001,27 @@ bool Worksheet::writeFormula(int row,
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
 
+    return writeFormula(row, column, formula, cellStyleIndex(fmt), result);
+}
+
+/*!
+        \overload
+
+        Write \a formula_ to the cell (\a row, \a column) with the style handle
+        \a style returned by Workbook::registerStyle() and \a result.
+        Returns true on success.
+*/
+bool Worksheet::writeFormula(int row,
+                             int column,
+                             const CellFormula &formula_,
+                             int style,
+                             double result)
+{
+    Q_D(Worksheet);
+
+    if (d->checkDimensions(row, column))
+        return false;
+
     CellFormula formula = formula_;
     formula.d->ca       = true;
     if (formula.formulaType() == CellFormula::SharedType) {
@@ -778,9 +1034,7 @@ bool Worksheet::writeFormula(int row,
         d->sharedFormulaMap[si] = formula;
     }
 
-    auto data            = std::make_shared<Cell>(result, Cell::NumberType, fmt, this);
-    data->d_ptr->formula = formula;
-    d->cellTable.setValue(row, column, data);
+    d->setCell(row, column, Cell::NumberType, result, d->cellStyle(row, column, style), formula);
 
     CellRange range = formula.reference();
     if (formula.formulaType() == CellFormula::SharedType) {
@@ -789,12 +1043,15 @@ bool Worksheet::writeFormula(int row,
         for (int r = range.firstRow(); r <= range.lastRow(); ++r) {
             for (int c = range.firstColumn(); c <= range.lastColumn(); ++c) {
                 if (!(r == row && c == column)) {
-                    if (auto cell = cellAt(r, c)) {
-                        cell->d_ptr->formula = sf;
+                    if (const CellData *cell = d->cellTable.cellAt(r, c)) {
+                        d->setCell(r,
+                                   c,
+                                   Cell::CellType(cell->type),
+                                   d->storedValue(*cell),
+                                   cell->style,
+                                   sf);
                     } else {
-                        auto newCell = std::make_shared<Cell>(result, Cell::NumberType, fmt, this);
-                        newCell->d_ptr->formula = sf;
-                        d->cellTable.setValue(r, c, newCell);
+                        d->setCell(r, c, Cell::NumberType, result, d->cellStyle(r, c, style), sf);
                     }
                 }
             }
@@ -831,8 +1088,25 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
     d->workbook->styles()->addXfFormat(fmt);
 
     // Note: NumberType with an invalid QVariant value means blank.
-    auto cell = std::make_shared<Cell>(QVariant{}, Cell::NumberType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::NumberType, QVariant{}, cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write a empty cell (\a row, \a column) with the style handle \a style
+        returned by Workbook::registerStyle().
+        Returns true on success.
+ */
+bool Worksheet::writeBlank(int row, int column, int style)
+{
+    Q_D(Worksheet);
+    if (d->checkDimensions(row, column))
+        return false;
+
+    d->setCell(row, column, Cell::NumberType, QVariant{}, d->cellStyle(row, column, style));
 
     return true;
 }
@@ -861,8 +1135,25 @@ bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
-    auto cell = std::make_shared<Cell>(value, Cell::BooleanType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::BooleanType, value, cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write a bool \a value to the cell (\a row, \a column) with the style
+        handle \a style returned by Workbook::registerStyle().
+        Returns true on success.
+ */
+bool Worksheet::writeBool(int row, int column, bool value, int style)
+{
+    Q_D(Worksheet);
+    if (d->checkDimensions(row, column))
+        return false;
+
+    d->setCell(row, column, Cell::BooleanType, value, d->cellStyle(row, column, style));
 
     return true;
 }
@@ -898,8 +1189,33 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
     double value = datetimeToNumber(dt, d->workbook->isDate1904());
 
-    auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::NumberType, value, cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write a QDateTime \a dt to the cell (\a row, \a column) with the style
+        handle \a style returned by Workbook::registerStyle(), which should
+        carry a date number format. KeepCellStyle keeps the cell's style and
+        adds the default date format if it has no date format,
+        ClearCellStyle uses the default date format alone.
+        Returns true on success.
+ */
+bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, int style)
+{
+    Q_D(Worksheet);
+    if (style == ClearCellStyle)
+        style = d->defaultDateStyle();
+    if (style < 0)
+        return writeDateTime(row, column, dt, Format());
+    if (d->checkDimensions(row, column))
+        return false;
+
+    double value = datetimeToNumber(dt, d->workbook->isDate1904());
+    d->setCell(row, column, Cell::NumberType, value, style);
 
     return true;
 }
@@ -929,8 +1245,23 @@ bool Worksheet::writeDate(int row, int column, const QDate &dt, const Format &fo
 
     double value = datetimeToNumber(QDateTime(dt, QTime(0, 0, 0)), d->workbook->isDate1904());
 
-    auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::NumberType, value, cellStyleIndex(fmt));
+
+    return true;
+}
+
+bool Worksheet::writeDate(int row, int column, const QDate &dt, int style)
+{
+    Q_D(Worksheet);
+    if (style == ClearCellStyle)
+        style = d->defaultDateStyle();
+    if (style < 0)
+        return writeDate(row, column, dt, Format());
+    if (d->checkDimensions(row, column))
+        return false;
+
+    double value = datetimeToNumber(QDateTime(dt, QTime(0, 0, 0)), d->workbook->isDate1904());
+    d->setCell(row, column, Cell::NumberType, value, style);
 
     return true;
 }
@@ -963,8 +1294,31 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
         fmt.setNumberFormat(QStringLiteral("hh:mm:ss"));
     d->workbook->styles()->addXfFormat(fmt);
 
-    auto cell = std::make_shared<Cell>(timeToNumber(t), Cell::NumberType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    d->setCell(row, column, Cell::NumberType, timeToNumber(t), cellStyleIndex(fmt));
+
+    return true;
+}
+
+/*!
+        \overload
+
+        Write a QTime \a t to the cell (\a row, \a column) with the style handle
+        \a style returned by Workbook::registerStyle(), which should carry a
+        time number format. KeepCellStyle keeps the cell's style and adds
+        "hh:mm:ss" if it has no time format, ClearCellStyle uses "hh:mm:ss"
+        alone. Returns true on success.
+ */
+bool Worksheet::writeTime(int row, int column, const QTime &t, int style)
+{
+    Q_D(Worksheet);
+    if (style == ClearCellStyle)
+        style = d->defaultTimeStyle();
+    if (style < 0)
+        return writeTime(row, column, t, Format());
+    if (d->checkDimensions(row, column))
+        return false;
+
+    d->setCell(row, column, Cell::NumberType, timeToNumber(t), style);
 
     return true;
 }
@@ -1038,9 +1392,8 @@ bool Worksheet::writeHyperlink(int row,
     d->workbook->styles()->addXfFormat(fmt);
 
     // Write the hyperlink string as normal string.
-    d->sharedStrings()->addSharedString(displayString);
-    auto cell = std::make_shared<Cell>(displayString, Cell::SharedStringType, fmt, this);
-    d->cellTable.setValue(row, column, cell);
+    const int sstIndex = d->sharedStrings()->addSharedString(displayString);
+    d->setCell(row, column, Cell::SharedStringType, sstIndex, cellStyleIndex(fmt));
 
     // Store the hyperlink data in a separate table
     d->urlTable[row][column] = std::make_shared<XlsxHyperlinkData>(
@@ -1049,6 +1402,259 @@ bool Worksheet::writeHyperlink(int row,
     return true;
 }
 
+/*!
+    Write \a count \a values to the cells of \a row starting at \a column.
+    \a styles holds one style handle per value, as taken by the int style
+    write overloads, or is null to keep the style each cell already has.
+
+    Values are converted as write() converts them, but the workbook
+    settings, the dimension and the row lookup are handled once per row
+    instead of once per cell. Dates and times without a style of their own
+    use the default date format and "hh:mm:ss".
+
+    Returns true if every value was written.
+ */
+bool Worksheet::writeRow(int row, int column, const QVariant *values, int count, const int *styles)
+{
+    Q_D(Worksheet);
+    if (count <= 0)
+        return count == 0;
+    if (d->checkDimensions(CellRange(row, column, row, column + count - 1)))
+        return false;
+
+    const bool stringsToHyperlinks = d->workbook->isStringsToHyperlinksEnabled();
+    const bool stringsToNumbers    = d->workbook->isStringsToNumbersEnabled();
+    const bool htmlToRichString    = d->workbook->isHtmlToRichStringEnabled();
+    const bool date1904            = d->workbook->isDate1904();
+    SharedStrings *sst             = d->sharedStrings();
+    qint32 dateStyle               = -1;
+    qint32 timeStyle               = -1;
+
+    const CellTable::Row *existing = d->cellTable.findRow(row);
+    QVarLengthArray<CellData, 64> cells(count);
+    QVarLengthArray<int, 8> deferred; // formulas, links and rich text take the per-cell path
+    bool ret = true;
+
+    for (int i = 0; i < count; ++i) {
+        const QVariant &value = values[i];
+        const int handle      = styles ? styles[i] : KeepCellStyle;
+        const qint32 style    = WorksheetPrivate::cellStyle(existing, column + i, handle);
+        CellData &cell        = cells[i];
+
+        if (value.isNull()) {
+            cell = blankCell(style);
+            continue;
+        }
+
+        switch (value.userType()) {
+        case QMetaType::QString: {
+            const QString token = value.toString();
+            double number       = 0;
+            switch (classifyCellString(token, stringsToHyperlinks, stringsToNumbers, &number)) {
+            case CellStringKind::Number:
+                cell = numberCell(number, style);
+                break;
+            case CellStringKind::Text:
+                if (htmlToRichString && Qt::mightBeRichText(token))
+                    deferred.append(i);
+                else
+                    cell = sharedStringCell(sst->addSharedString(token), style);
+                break;
+            default:
+                deferred.append(i);
+                break;
+            }
+            break;
+        }
+        case QMetaType::Double:
+        case QMetaType::Float:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            cell = numberCell(value.toDouble(), style);
+            break;
+        case QMetaType::Bool:
+            cell = boolCell(value.toBool(), style);
+            break;
+        case QMetaType::QDateTime:
+        case QMetaType::QDate: {
+            // A kept style may lack a date format, write() adds it
+            if (handle < 0 && style >= 0) {
+                deferred.append(i);
+                break;
+            }
+            if (style < 0 && dateStyle < 0)
+                dateStyle = d->defaultDateStyle();
+            const QDateTime dt = value.userType() == QMetaType::QDate
+                                     ? QDateTime(value.toDate(), QTime(0, 0, 0))
+                                     : value.toDateTime();
+            cell = numberCell(datetimeToNumber(dt, date1904), style >= 0 ? style : dateStyle);
+            break;
+        }
+        case QMetaType::QTime:
+            if (handle < 0 && style >= 0) {
+                deferred.append(i);
+                break;
+            }
+            if (style < 0 && timeStyle < 0)
+                timeStyle = d->defaultTimeStyle();
+            cell = numberCell(timeToNumber(value.toTime()), style >= 0 ? style : timeStyle);
+            break;
+        case QMetaType::QUrl:
+            deferred.append(i);
+            break;
+        default:
+            if (value.userType() == qMetaTypeId<RichString>())
+                deferred.append(i);
+            else
+                ret = false; // Wrong type, the cell is left untouched
+            break;
+        }
+    }
+
+    // Deferred cells are left untouched here and write() keeps their style
+    // for an empty format, so a cleared style is dropped from them first
+    if (styles) {
+        for (int i : deferred) {
+            if (styles[i] == ClearCellStyle)
+                cells[i] = blankCell(-1);
+        }
+    }
+
+    d->cellTable.setCells(row, column, cells.constData(), count);
+
+    for (int i : deferred) {
+        const Format format =
+            styles && styles[i] >= 0 ? d->workbook->styles()->xfFormat(styles[i]) : Format();
+        if (!write(row, column + i, values[i], format))
+            ret = false;
+    }
+
+    return ret;
+}
+
+/*!
+    \overload
+
+    Write \a values to the cells of \a row starting at \a column. \a styles
+    must be empty or hold one style handle per value.
+ */
+bool Worksheet::writeRow(int row,
+                         int column,
+                         const QVector<QVariant> &values,
+                         const QVector<int> &styles)
+{
+    if (!styles.isEmpty() && styles.size() < values.size())
+        return false;
+
+    return writeRow(row,
+                    column,
+                    values.constData(),
+                    int(values.size()),
+                    styles.isEmpty() ? nullptr : styles.constData());
+}
+
+/*!
+    Write \a values to the row below the last used row, starting at the
+    first column. \a styles must be empty or hold one style handle per value.
+
+    Returns true on success.
+ */
+bool Worksheet::appendRow(const QVector<QVariant> &values, const QVector<int> &styles)
+{
+    Q_D(const Worksheet);
+    return writeRow(qMax(d->dimension.lastRow(), 0) + 1, 1, values, styles);
+}
+
+/*!
+    Write the numbers \a values down \a column starting at \a row, with the
+    style handle \a style as taken by the int style write overloads; the
+    default keeps the style each cell already has. Returns true on success.
+ */
+bool Worksheet::writeColumn(int row, int column, const QVector<double> &values, int style)
+{
+    Q_D(Worksheet);
+    if (values.isEmpty())
+        return true;
+    if (d->checkDimensions(CellRange(row, column, row + int(values.size()) - 1, column)))
+        return false;
+
+    for (int i = 0; i < values.size(); ++i)
+        d->cellTable.setValue(
+            row + i, column, numberCell(values[i], d->cellStyle(row + i, column, style)));
+
+    return true;
+}
+
+/*!
+    \overload
+
+    Write the strings \a values down \a column starting at \a row, with the
+    style handle \a style. The strings are stored as they are, without the
+    formula, number and hyperlink conversions of write().
+ */
+bool Worksheet::writeColumn(int row, int column, const QStringList &values, int style)
+{
+    Q_D(Worksheet);
+    if (values.isEmpty())
+        return true;
+    if (d->checkDimensions(CellRange(row, column, row + int(values.size()) - 1, column)))
+        return false;
+
+    const bool htmlToRichString = d->workbook->isHtmlToRichStringEnabled();
+    SharedStrings *sst          = d->sharedStrings();
+    bool ret                    = true;
+    for (int i = 0; i < values.size(); ++i) {
+        const QString &value = values[i];
+        if (htmlToRichString && Qt::mightBeRichText(value)) {
+            if (!writeString(row + i, column, value, style))
+                ret = false;
+            continue;
+        }
+        d->cellTable.setValue(row + i,
+                              column,
+                              sharedStringCell(sst->addSharedString(value),
+                                               d->cellStyle(row + i, column, style)));
+    }
+
+    return ret;
+}
+
+/*!
+    \overload
+
+    Write the date-times \a values down \a column starting at \a row, with
+    the style handle \a style. Cells written without a style of their own
+    use the default date format, kept styles get it added as writeDateTime()
+    does.
+ */
+bool Worksheet::writeColumn(int row, int column, const QVector<QDateTime> &values, int style)
+{
+    Q_D(Worksheet);
+    if (values.isEmpty())
+        return true;
+    if (d->checkDimensions(CellRange(row, column, row + int(values.size()) - 1, column)))
+        return false;
+
+    const bool date1904    = d->workbook->isDate1904();
+    const qint32 dateStyle = style >= 0 ? style : d->defaultDateStyle();
+    bool ret               = true;
+    for (int i = 0; i < values.size(); ++i) {
+        const qint32 cellStyle = d->cellStyle(row + i, column, style);
+        if (style < 0 && cellStyle >= 0) {
+            // A kept style may lack a date format
+            if (!writeDateTime(row + i, column, values[i], Format()))
+                ret = false;
+            continue;
+        }
+        d->cellTable.setValue(
+            row + i, column, numberCell(datetimeToNumber(values[i], date1904), dateStyle));
+    }
+
+    return ret;
+}
+
 /*!
  * Add one DataValidation \a validation to the sheet.
  * Returns true on success.
@@ -1228,10 +1834,23 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
     for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
         for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
             if (row == range.firstRow() && col == range.firstColumn()) {
-                auto cell = cellAt(row, col);
+                // cellAt() only returns a snapshot, so the cell is stored
+                // again with its value and formula under the new style
+                const CellData *cell = d->cellTable.cellAt(row, col);
                 if (cell) {
-                    if (format.isValid())
-                        cell->d_ptr->format = format;
+                    if (format.isValid()) {
+                        const CellData data       = *cell;
+                        const QVariant value      = d->storedValue(data);
+                        const CellFormula formula = (data.flags & CellData::HasExtra)
+                                                        ? d->cellTable.extraAt(data.index).formula
+                                                        : CellFormula();
+                        d->setCell(row,
+                                   col,
+                                   Cell::CellType(data.type),
+                                   value,
+                                   cellStyleIndex(format),
+                                   formula);
+                    }
                 } else {
                     writeBlank(row, col, format);
                 }
@@ -1376,8 +1995,12 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
     }
 
     writer.writeStartElement(QStringLiteral("sheetData"));
-    if (d->dimension.isValid())
-        d->saveXmlSheetData(writer);
+    if (d->dimension.isValid()) {
+        // Close the start tag, then write the rows straight to the device
+        writer.writeCharacters(QString());
+        SheetDataWriter sheetData(device);
+        d->saveXmlSheetData(sheetData);
+    }
     writer.writeEndElement(); // sheetData
 
     d->saveXmlMergeCells(writer);
@@ -1487,223 +2110,308 @@ bool Worksheet::setStartPage(int spagen)
 }
 //}}
 
-void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
-{
-    calculateSpans();
+/*
+  Column range of the cells in the 16-row block \a block, used for the
+  "spans" attribute of its <row> tags. This is an XLSX optimisation and
+  isn't strictly required, but it makes comparing files easier. Returns
+  false if the block has no cells.
+ */
+bool WorksheetPrivate::blockSpan(int block, int *first, int *last) const
+{
+    const int firstRow = qMax(block * 16 + 1, dimension.firstRow());
+    const int lastRow  = qMin(block * 16 + 16, dimension.lastRow());
+    int spanMin        = XLSX_COLUMN_MAX + 1;
+    int spanMax        = -1;
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        // Cells of a row are stored in column order, only its ends matter
+        if (const CellTable::Row *cellRow = cellTable.findRow(row)) {
+            spanMin = qMin(spanMin, qMax(cellRow->firstColumn(), dimension.firstColumn()));
+            spanMax = qMax(spanMax, qMin(cellRow->lastColumn(), dimension.lastColumn()));
+        }
 
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        auto ctIt = cellTable.cells.constFind(row_num);
-        auto riIt = rowsInfo.constFind(row_num);
-        if (ctIt == cellTable.cells.constEnd() && riIt == rowsInfo.constEnd() &&
-            !comments.contains(row_num)) {
-            // Only process rows with cell data / comments / formatting
-            continue;
+        auto cIt = comments.constFind(row);
+        if (cIt != comments.constEnd()) {
+            for (auto it = cIt->constBegin(); it != cIt->constEnd(); ++it) {
+                if (it.key() >= dimension.firstColumn() && it.key() <= dimension.lastColumn()) {
+                    spanMin = qMin(spanMin, it.key());
+                    spanMax = qMax(spanMax, it.key());
+                }
+            }
         }
+    }
 
-        int span_index = (row_num - 1) / 16;
-        QString span;
-        auto rsIt = row_spans.constFind(span_index);
-        if (rsIt != row_spans.constEnd())
-            span = rsIt.value();
+    *first = spanMin;
+    *last  = spanMax;
+    return spanMin <= spanMax;
+}
 
-        writer.writeStartElement(QStringLiteral("row"));
-        writer.writeAttribute(QStringLiteral("r"), QString::number(row_num));
+/*
+  Writes the rows of <sheetData>. Rows come from the cell table in order,
+  merged with the rows that only carry formatting or comments, and spans
+  are worked out as each block of 16 rows is entered.
+ */
+void WorksheetPrivate::saveXmlSheetData(SheetDataWriter &writer) const
+{
+    std::vector<int> extraRows;
+    for (auto it = rowsInfo.constBegin(); it != rowsInfo.constEnd(); ++it)
+        extraRows.push_back(it.key());
+    for (auto it = comments.constBegin(); it != comments.constEnd(); ++it)
+        extraRows.push_back(it.key());
+    std::sort(extraRows.begin(), extraRows.end());
+    extraRows.erase(std::unique(extraRows.begin(), extraRows.end()), extraRows.end());
+
+    int spanBlock = -1;
+    int spanFirst = 0;
+    int spanLast  = -1;
+    bool hasSpan  = false;
+
+    auto saveRow = [&](int row_num, const CellTable::Row *cellRow) {
+        if (row_num < dimension.firstRow() || row_num > dimension.lastRow())
+            return;
+
+        const int block = (row_num - 1) / 16;
+        if (block != spanBlock) {
+            spanBlock = block;
+            hasSpan   = blockSpan(block, &spanFirst, &spanLast);
+        }
 
-        if (!span.isEmpty())
-            writer.writeAttribute(QStringLiteral("spans"), span);
+        writer.writeLiteral("<row r=\"");
+        writer.writeInt(row_num);
+        writer.writeLiteral("\"");
+        if (hasSpan) {
+            writer.writeLiteral(" spans=\"");
+            writer.writeInt(spanFirst);
+            writer.writeLiteral(":");
+            writer.writeInt(spanLast);
+            writer.writeLiteral("\"");
+        }
 
+        int rowStyle = -1;
+        auto riIt    = rowsInfo.constFind(row_num);
         if (riIt != rowsInfo.constEnd()) {
             std::shared_ptr<XlsxRowInfo> rowInfo = riIt.value();
             if (!rowInfo->format.isEmpty()) {
-                writer.writeAttribute(QStringLiteral("s"),
-                                      QString::number(rowInfo->format.xfIndex()));
-                writer.writeAttribute(QStringLiteral("customFormat"), QStringLiteral("1"));
+                rowStyle = rowInfo->format.xfIndex();
+                writer.writeLiteral(" s=\"");
+                writer.writeInt(rowStyle);
+                writer.writeLiteral("\" customFormat=\"1\"");
             }
 
             //! Todo: support customHeight from info struct
             //! Todo: where does this magic number '15' come from?
             if (rowInfo->customHeight) {
-                writer.writeAttribute(QStringLiteral("ht"), QString::number(rowInfo->height));
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("1"));
+                const QByteArray height = QByteArray::number(rowInfo->height);
+                writer.writeLiteral(" ht=\"");
+                writer.writeRaw(height.constData(), size_t(height.size()));
+                writer.writeLiteral("\" customHeight=\"1\"");
             } else {
-                writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("0"));
+                writer.writeLiteral(" customHeight=\"0\"");
             }
 
             if (rowInfo->hidden)
-                writer.writeAttribute(QStringLiteral("hidden"), QStringLiteral("1"));
-            if (rowInfo->outlineLevel > 0)
-                writer.writeAttribute(QStringLiteral("outlineLevel"),
-                                      QString::number(rowInfo->outlineLevel));
+                writer.writeLiteral(" hidden=\"1\"");
+            if (rowInfo->outlineLevel > 0) {
+                writer.writeLiteral(" outlineLevel=\"");
+                writer.writeInt(rowInfo->outlineLevel);
+                writer.writeLiteral("\"");
+            }
             if (rowInfo->collapsed)
-                writer.writeAttribute(QStringLiteral("collapsed"), QStringLiteral("1"));
+                writer.writeLiteral(" collapsed=\"1\"");
         }
 
         // Write cell data if row contains filled cells
-        if (ctIt != cellTable.cells.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                auto cellIt = ctIt->find(col_num);
-                if (cellIt != ctIt->end()) {
-                    saveXmlCellData(writer, row_num, col_num, *cellIt);
+        bool open = false;
+        if (cellRow) {
+            cellRow->forEach([&](int col_num, const CellData &cell) {
+                if (col_num < dimension.firstColumn() || col_num > dimension.lastColumn())
+                    return;
+                if (!open) {
+                    writer.writeLiteral(">");
+                    open = true;
                 }
-            }
+                saveXmlCellData(writer, row_num, col_num, cell, rowStyle);
+            });
         }
-        writer.writeEndElement(); // row
-    }
+        if (open)
+            writer.writeLiteral("</row>");
+        else
+            writer.writeLiteral("/>");
+    };
+
+    size_t next = 0;
+    cellTable.forEachRow([&](const CellTable::Row &cellRow) {
+        for (; next < extraRows.size() && extraRows[next] < cellRow.row(); ++next)
+            saveRow(extraRows[next], nullptr);
+        if (next < extraRows.size() && extraRows[next] == cellRow.row())
+            ++next;
+        saveRow(cellRow.row(), &cellRow);
+    });
+    for (; next < extraRows.size(); ++next)
+        saveRow(extraRows[next], nullptr);
 }
 
-void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer,
+/*
+  Writes one <c> element. \a rowStyle is the xf index of the row format,
+  or -1, and is used for cells without a format of their own.
+ */
+void WorksheetPrivate::saveXmlCellData(SheetDataWriter &writer,
                                        int row,
                                        int col,
-                                       std::shared_ptr<Cell> cell) const
+                                       const CellData &cell,
+                                       int rowStyle) const
 {
     // This is the innermost loop so efficiency is important.
-    QString cell_pos = CellReference(row, col).toString();
-
-    writer.writeStartElement(QStringLiteral("c"));
-    writer.writeAttribute(QStringLiteral("r"), cell_pos);
+    writer.writeLiteral("<c r=\"");
+    writer.writeCellReference(row, col);
+    writer.writeLiteral("\"");
 
     // Style used by the cell, row or col
-    if (!cell->format().isEmpty()) {
-        writer.writeAttribute(QStringLiteral("s"), QString::number(cell->format().xfIndex()));
-    } else {
-        auto rIt = rowsInfo.constFind(row);
-        if (rIt != rowsInfo.constEnd() && !(*rIt)->format.isEmpty()) {
-            writer.writeAttribute(QStringLiteral("s"), QString::number((*rIt)->format.xfIndex()));
-        } else {
-            auto cIt = colsInfoHelper.constFind(col);
-            if (cIt != colsInfoHelper.constEnd() && !(*cIt)->format.isEmpty()) {
-                writer.writeAttribute(QStringLiteral("s"),
-                                      QString::number((*cIt)->format.xfIndex()));
-            }
-        }
+    int style = cell.style >= 0 ? cell.style : rowStyle;
+    if (style < 0 && !colsInfoHelper.isEmpty()) {
+        auto cIt = colsInfoHelper.constFind(col);
+        if (cIt != colsInfoHelper.constEnd() && !(*cIt)->format.isEmpty())
+            style = (*cIt)->format.xfIndex();
+    }
+    if (style >= 0) {
+        writer.writeLiteral(" s=\"");
+        writer.writeInt(style);
+        writer.writeLiteral("\"");
     }
 
-    if (cell->cellType() == Cell::SharedStringType) // 's'
-    {
-        int sst_idx;
-        if (cell->isRichString())
-            sst_idx = sharedStrings()->getSharedStringIndex(cell->d_ptr->richString);
-        else
-            sst_idx = sharedStrings()->getSharedStringIndex(cell->value().toString());
+    const CellExtra *extra =
+        (cell.flags & CellData::HasExtra) ? &cellTable.extraAt(cell.index) : nullptr;
 
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("s"));
-        writer.writeTextElement(QStringLiteral("v"), QString::number(sst_idx));
-    } else if (cell->cellType() == Cell::InlineStringType) // 'inlineStr'
-    {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("inlineStr"));
-        writer.writeStartElement(QStringLiteral("is"));
-        if (cell->isRichString()) {
+    if (cell.type == Cell::SharedStringType) { // 's'
+        writer.writeLiteral(" t=\"s\"><v>");
+        writer.writeInt(extra ? extra->value.toInt() : cell.index);
+        writer.writeLiteral("</v></c>");
+        return;
+    }
+    if (cell.type == Cell::InlineStringType) { // 'inlineStr'
+        const QVariant value = extra ? extra->value : QVariant();
+        writer.writeLiteral(" t=\"inlineStr\"><is>");
+        if (value.userType() == qMetaTypeId<RichString>() &&
+            value.value<RichString>().isRichString()) {
             // Rich text string
-            RichString string = cell->d_ptr->richString;
+            const RichString string = value.value<RichString>();
             for (int i = 0; i < string.fragmentCount(); ++i) {
-                writer.writeStartElement(QStringLiteral("r"));
+                writer.writeLiteral("<r>");
                 if (string.fragmentFormat(i).hasFontData()) {
-                    writer.writeStartElement(QStringLiteral("rPr"));
                     //: Todo
-                    writer.writeEndElement(); // rPr
+                    writer.writeLiteral("<rPr/>");
                 }
-                writer.writeStartElement(QStringLiteral("t"));
-                if (isSpaceReserveNeeded(string.fragmentText(i)))
-                    writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-                writer.writeCharacters(string.fragmentText(i));
-                writer.writeEndElement(); // t
-                writer.writeEndElement(); // r
+                const QString text = string.fragmentText(i);
+                writer.writeLiteral("<t");
+                if (isSpaceReserveNeeded(text))
+                    writer.writeLiteral(" xml:space=\"preserve\"");
+                writer.writeLiteral(">");
+                writer.writeEscaped(text);
+                writer.writeLiteral("</t></r>");
             }
         } else {
-            writer.writeStartElement(QStringLiteral("t"));
-            QString string = cell->value().toString();
+            const QString string = value.userType() == qMetaTypeId<RichString>()
+                                       ? value.value<RichString>().toPlainString()
+                                       : value.toString();
+            writer.writeLiteral("<t");
             if (isSpaceReserveNeeded(string))
-                writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-            writer.writeCharacters(string);
-            writer.writeEndElement(); // t
+                writer.writeLiteral(" xml:space=\"preserve\"");
+            writer.writeLiteral(">");
+            writer.writeEscaped(string);
+            writer.writeLiteral("</t>");
         }
-        writer.writeEndElement();                    // is
-    } else if (cell->cellType() == Cell::NumberType) // 'n'
-    {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n")); // dev67
-
-        if (cell->hasFormula()) {
-            QString strFormula = cell->formula().d->formula;
-            Q_UNUSED(strFormula);
-            cell->formula().saveToXml(writer);
-        }
-
-        if (cell->value().isValid()) { // note that, invalid value means 'v' is blank
-            double value = cell->value().toDouble();
-            writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
-        }
-    } else if (cell->cellType() == Cell::StringType) // 'str'
-    {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("str"));
-        if (cell->hasFormula())
-            cell->formula().saveToXml(writer);
-
-        writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
-    } else if (cell->cellType() == Cell::BooleanType) // 'b'
-    {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("b"));
-
-        // dev34
+        writer.writeLiteral("</is></c>");
+        return;
+    }
 
-        if (cell->hasFormula()) {
-            QString strFormula = cell->formula().d->formula;
-            Q_UNUSED(strFormula);
-            cell->formula().saveToXml(writer);
+    // The formula, if any, and the <v> element follow the attributes
+    bool saveFormula = extra && extra->formula.isValid();
+    bool hasNumber   = false;
+    bool hasText     = false;
+    double number    = 0;
+    QString text;
+
+    switch (cell.type) {
+    case Cell::NumberType: // 'n'
+        writer.writeLiteral(" t=\"n\""); // dev67
+        Q_FALLTHROUGH();
+    default: // Cell::CustomType
+        // note that, invalid value means 'v' is blank
+        if (cell.flags & CellData::HasValue) {
+            hasNumber = true;
+            number    = cell.number;
+        } else if (extra && extra->value.isValid()) {
+            hasNumber = true;
+            number    = extra->value.toDouble();
         }
-
-        writer.writeTextElement(QStringLiteral("v"),
-                                cell->value().toBool() ? QStringLiteral("1") : QStringLiteral("0"));
-    } else if (cell->cellType() == Cell::DateType) // 'd'
-    {
+        break;
+    case Cell::StringType: // 'str'
+        writer.writeLiteral(" t=\"str\"");
+        hasText = true;
+        text    = storedValue(cell).toString();
+        break;
+    case Cell::BooleanType: // 'b'
+        writer.writeLiteral(" t=\"b\"");
+        hasNumber = true;
+        number    = storedValue(cell).toBool() ? 1 : 0;
+        break;
+    case Cell::DateType: { // 'd'
         // number type. see for 18.18.11 ST_CellType (Cell Type) more information.
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n"));
+        writer.writeLiteral(" t=\"n\"");
+        saveFormula          = false;
+        const QVariant value = storedValue(cell);
 
         // Legacy mode: write date as text (old behavior)
         if (workbook && workbook->writeDatesAsText()) {
-            writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
-        } else {
-            if (cell->value().isValid()) {
-                double serial = 0.0;
-
-                if (SAME_METATYPE_ID(cell->value(), QMetaType::QDateTime)) {
-                    const QDateTime dt = cell->value().toDateTime();
-                    serial = datetimeToNumber(dt, workbook ? workbook->isDate1904() : false);
-                } else if (SAME_METATYPE_ID(cell->value(), QMetaType::QDate)) {
-                    const QDate d = cell->value().toDate();
-                    const QDateTime dt(d, QTime(0, 0));
-                    serial = datetimeToNumber(dt, workbook ? workbook->isDate1904() : false);
-                } else if (SAME_METATYPE_ID(cell->value(), QMetaType::QTime)) {
-                    serial = timeToNumber(cell->value().toTime());
-                } else {
-                    // Already a serial (e.g., from earlier pipeline stage).
-                    serial = cell->value().toDouble();
-                }
-
-                writer.writeTextElement(QStringLiteral("v"), QString::number(serial, 'g', 15));
+            hasText = true;
+            text    = value.toString();
+        } else if (value.isValid()) {
+            const bool is1904 = workbook ? workbook->isDate1904() : false;
+            hasNumber         = true;
+            if (SAME_METATYPE_ID(value, QMetaType::QDateTime)) {
+                number = datetimeToNumber(value.toDateTime(), is1904);
+            } else if (SAME_METATYPE_ID(value, QMetaType::QDate)) {
+                number = datetimeToNumber(QDateTime(value.toDate(), QTime(0, 0)), is1904);
+            } else if (SAME_METATYPE_ID(value, QMetaType::QTime)) {
+                number = timeToNumber(value.toTime());
+            } else {
+                // Already a serial (e.g., from earlier pipeline stage).
+                number = value.toDouble();
             }
         }
-    } else if (cell->cellType() == Cell::ErrorType) // 'e'
-    {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("e"));
-        writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
-    } else // if (cell->cellType() == Cell::CustomType)
-    {
-        // custom type
-
-        if (cell->hasFormula()) {
-            QString strFormula = cell->formula().d->formula;
-            Q_UNUSED(strFormula);
-            cell->formula().saveToXml(writer);
-        }
+        break;
+    }
+    case Cell::ErrorType: // 'e'
+        writer.writeLiteral(" t=\"e\"");
+        saveFormula = false;
+        hasText     = true;
+        text        = storedValue(cell).toString();
+        break;
+    }
 
-        if (cell->value().isValid()) { // note that, invalid value means 'v' is blank
-            double value = cell->value().toDouble();
-            writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
-        }
+    if (!saveFormula && !hasNumber && !hasText) {
+        writer.writeLiteral("/>");
+        return;
     }
 
-    writer.writeEndElement(); // c
+    writer.writeLiteral(">");
+    if (saveFormula) {
+        // Formulas are rare, so CellFormula writes its own element
+        QByteArray xml;
+        QXmlStreamWriter formulaWriter(&xml);
+        extra->formula.saveToXml(formulaWriter);
+        writer.writeRaw(xml.constData(), size_t(xml.size()));
+    }
+    if (hasNumber) {
+        writer.writeLiteral("<v>");
+        writer.writeDouble(number);
+        writer.writeLiteral("</v>");
+    } else if (hasText) {
+        writer.writeLiteral("<v>");
+        writer.writeEscaped(text);
+        writer.writeLiteral("</v>");
+    }
+    writer.writeLiteral("</c>");
 }
 
 void WorksheetPrivate::saveXmlMergeCells(QXmlStreamWriter &writer) const
@@ -2274,8 +2982,6 @@ int WorksheetPrivate::colPixelsSize(int col) const
 
 void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 {
-    Q_Q(Worksheet);
-
     Q_ASSERT(reader.name() == QLatin1String("sheetData"));
 
     int row_num = 0;
@@ -2356,7 +3062,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                     //"s" == style index
                     int idx    = attributes.value(QLatin1String("s")).toInt();
                     format     = workbook->styles()->xfFormat(idx);
-                    styleIndex = idx;
+                    styleIndex = format.isValid() ? idx : -1;
                 }
 
                 // Cell::CellType cellType = Cell::NumberType;
@@ -2396,15 +3102,14 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                     cellType = Cell::DateType;
                 }
 
-                // create a heap of new cell
-                auto cell = std::make_shared<Cell>(QVariant{}, cellType, format, q, styleIndex);
+                QVariant value;
+                CellFormula formula;
 
                 while (!reader.atEnd() && !(reader.name() == QLatin1String("c") &&
                                             reader.tokenType() == QXmlStreamReader::EndElement)) {
                     if (reader.readNextStartElement()) {
                         if (reader.name() == QLatin1String("f")) // formula
                         {
-                            CellFormula &formula = cell->d_func()->formula;
                             formula.loadFromXml(reader);
                             if (formula.formulaType() == CellFormula::SharedType &&
                                 !formula.formulaText().isEmpty()) {
@@ -2413,32 +3118,22 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                             }
                         } else if (reader.name() == QLatin1String("v")) // Value
                         {
-                            QString value = reader.readElementText();
+                            QString text = reader.readElementText();
                             if (cellType == Cell::SharedStringType) {
-                                int sst_idx = value.toInt();
+                                // Shared string cells keep the string index
+                                int sst_idx = text.toInt();
                                 sharedStrings()->incRefByStringIndex(sst_idx);
-                                RichString rs          = sharedStrings()->getSharedString(sst_idx);
-                                QString strPlainString = rs.toPlainString();
-                                cell->d_func()->value  = strPlainString;
-                                if (rs.isRichString())
-                                    cell->d_func()->richString = rs;
+                                value = sst_idx;
                             } else if (cellType == Cell::NumberType) {
-                                cell->d_func()->value = value.toDouble();
+                                value = text.toDouble();
                             } else if (cellType == Cell::BooleanType) {
-                                cell->d_func()->value = value.toInt() ? true : false;
+                                value = text.toInt() ? true : false;
                             } else if (cellType == Cell::DateType) {
                                 // [dev54] DateType
-
-                                double dValue    = value.toDouble(); // days from 1900(or 1904)
-                                bool bIsDate1904 = q->workbook()->isDate1904();
-
-                                QVariant vDatetimeValue = datetimeFromNumber(dValue, bIsDate1904);
-                                Q_UNUSED(vDatetimeValue);
-                                // cell->d_func()->value = vDatetimeValue;
-                                cell->d_func()->value = dValue; // dev67
+                                value = text.toDouble(); // days from 1900(or 1904), dev67
                             } else {
                                 // ELSE type
-                                cell->d_func()->value = value;
+                                value = text;
                             }
 
                         } else if (reader.name() == QLatin1String("is")) {
@@ -2448,7 +3143,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                                 if (reader.readNextStartElement()) {
                                     //: Todo, add rich text read support
                                     if (reader.name() == QLatin1String("t")) {
-                                        cell->d_func()->value = reader.readElementText();
+                                        value = reader.readElementText();
                                     }
                                 }
                             }
@@ -2463,7 +3158,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                     }
                 }
 
-                cellTable.setValue(pos.row(), pos.column(), cell);
+                setCell(pos.row(), pos.column(), cellType, value, styleIndex, formula);
             }
         }
     }
@@ -2879,32 +3574,25 @@ QVector<CellLocation> Worksheet::getFullCells(int *maxRow, int *maxCol) const
         return ret;
     }
 
-    const auto sortedRows = d->cellTable.sortedRows();
-    for (const auto row : sortedRows) {
-        const auto &columns      = d->cellTable.cells[row];
-        const auto columnsSorted = CellTable::sorteIntList(columns.keys());
-        for (const auto &col : columnsSorted) {
-            // It's faster to iterate but cellTable is unordered which might not
-            // be what callers want?
-            auto cell = std::make_shared<Cell>(columns.value(col).get());
-
-            CellLocation cl;
+    // The cell table iterates in row-major order, no sorting needed
+    ret.reserve(d->cellTable.cellCount());
+    d->cellTable.forEachCell([&](int row, int col, const CellData &source) {
+        CellLocation cl;
 
-            cl.row = row;
-            if (row > (*maxRow)) {
-                (*maxRow) = row;
-            }
+        cl.row = row;
+        if (row > (*maxRow)) {
+            (*maxRow) = row;
+        }
 
-            cl.col = col;
-            if (col > (*maxCol)) {
-                (*maxCol) = col;
-            }
+        cl.col = col;
+        if (col > (*maxCol)) {
+            (*maxCol) = col;
+        }
 
-            cl.cell = cell;
+        cl.cell = d->createCell(source);
 
-            ret.push_back(cl);
-        }
-    }
+        ret.push_back(cl);
+    });
 
     return ret;
 }
@@ -2,48 +2,492 @@
 
 #include "xlsxzipreader_p.h"
 
-#include <private/qzipreader_p.h>
+#include <cstring>
+#include <limits>
+
+#include <zlib.h>
+
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+namespace {
+
+const quint32 kLocalHeaderSignature         = 0x04034b50;
+const quint32 kCentralHeaderSignature       = 0x02014b50;
+const quint32 kEndOfDirectorySignature      = 0x06054b50;
+const quint32 kZip64EndOfDirectorySignature = 0x06064b50;
+const quint32 kZip64LocatorSignature        = 0x07064b50;
+const quint16 kUtf8NameFlag                 = 0x0800;
+const quint16 kMethodStored                 = 0;
+const quint16 kMethodDeflated               = Z_DEFLATED;
+const quint16 kZip64ExtraId                 = 0x0001;
+const quint32 kZip64Marker                  = 0xffffffff;
+
+const int kLocalHeaderSize         = 30;
+const int kCentralHeaderSize       = 46;
+const int kEndOfDirectorySize      = 22;
+const int kZip64EndOfDirectorySize = 56;
+const int kZip64LocatorSize        = 20;
+
+// Compressed bytes handed to inflate at a time by an entry device
+const qint64 kReadChunk   = 64 * 1024;        // read from an unmapped device
+const qint64 kMappedChunk = 64 * 1024 * 1024; // viewed in a mapping, no copy
+
+quint16 readLE16(const char *p)
+{
+    const uchar *u = reinterpret_cast<const uchar *>(p);
+    return quint16(u[0] | (u[1] << 8));
+}
+
+quint32 readLE32(const char *p)
+{
+    return quint32(readLE16(p)) | (quint32(readLE16(p + 2)) << 16);
+}
+
+quint64 readLE64(const char *p)
+{
+    return quint64(readLE32(p)) | (quint64(readLE32(p + 4)) << 32);
+}
+
+} // namespace
+
+/*
+  Read-only device over one entry. Compressed bytes are taken from the
+  archive a chunk at a time and inflated straight into the caller's
+  buffer, so reading an entry of any size needs a fixed amount of memory.
+  The CRC is checked once the last byte has been read.
+ */
+class ZipReader::EntryDevice : public QIODevice
+{
+public:
+    EntryDevice(const ZipReader *reader, const Entry &entry, qint64 dataOffset)
+        : m_reader(reader)
+        , m_entry(entry)
+        , m_inputOffset(dataOffset)
+        , m_inputLeft(entry.compressedSize)
+        , m_remaining(entry.uncompressedSize)
+        , m_stream(z_stream())
+        , m_crc(crc32(0, Z_NULL, 0))
+    {
+        m_inflating =
+            m_entry.method == kMethodDeflated && inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+        if (m_entry.method == kMethodStored || m_inflating)
+            open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    ~EntryDevice() override
+    {
+        if (m_inflating)
+            inflateEnd(&m_stream);
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_remaining + QIODevice::bytesAvailable(); }
+    bool atEnd() const override { return m_remaining == 0 && QIODevice::bytesAvailable() == 0; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 wanted = qMin(maxSize, m_remaining);
+        if (wanted <= 0)
+            return 0;
+
+        qint64 produced = 0;
+        if (m_entry.method == kMethodStored) {
+            while (produced < wanted) {
+                if (m_stream.avail_in == 0 && !fillInput())
+                    break;
+                const qint64 n = qMin<qint64>(m_stream.avail_in, wanted - produced);
+                memcpy(data + produced, m_stream.next_in, size_t(n));
+                m_stream.next_in += n;
+                m_stream.avail_in -= uInt(n);
+                produced += n;
+            }
+        } else {
+            m_stream.next_out   = reinterpret_cast<Bytef *>(data);
+            m_stream.avail_out  = uInt(qMin<qint64>(wanted, std::numeric_limits<int>::max()));
+            const uInt capacity = m_stream.avail_out;
+            while (m_stream.avail_out > 0) {
+                if (m_stream.avail_in == 0 && !fillInput())
+                    break;
+                const int ret = inflate(&m_stream, Z_NO_FLUSH);
+                if (ret == Z_STREAM_END)
+                    break;
+                if (ret != Z_OK)
+                    return fail();
+            }
+            produced = qint64(capacity - m_stream.avail_out);
+        }
+
+        // The entry ends before the size its directory record promises
+        if (produced == 0)
+            return fail();
+
+        m_crc = crc32(m_crc, reinterpret_cast<const Bytef *>(data), uInt(produced));
+        m_remaining -= produced;
+        if (m_remaining == 0 && quint32(m_crc) != m_entry.crc)
+            return fail();
+        return produced;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    // Points the stream at the next chunk of compressed bytes.
+    bool fillInput()
+    {
+        if (m_inputLeft <= 0)
+            return false;
+        const qint64 chunk = qMin(m_inputLeft, m_reader->m_data ? kMappedChunk : kReadChunk);
+        m_input            = m_reader->readAt(m_inputOffset, chunk);
+        if (m_input.size() != chunk)
+            return false;
+        m_stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(m_input.constData()));
+        m_stream.avail_in = uInt(chunk);
+        m_inputOffset += chunk;
+        m_inputLeft -= chunk;
+        return true;
+    }
+
+    qint64 fail()
+    {
+        setErrorString(QStringLiteral("Corrupt zip entry"));
+        m_remaining = 0;
+        return -1;
+    }
+
+    const ZipReader *m_reader;
+    const Entry m_entry;
+    qint64 m_inputOffset; // next compressed byte in the archive
+    qint64 m_inputLeft;   // compressed bytes not yet handed to the stream
+    qint64 m_remaining;   // uncompressed bytes not yet returned
+    QByteArray m_input;   // current compressed chunk, a view when mapped
+    z_stream m_stream;
+    uLong m_crc;
+    bool m_inflating = false;
+};
+
 ZipReader::ZipReader(const QString &filePath)
-    : m_reader(new QZipReader(filePath))
+    : m_ownedFile(new QFile(filePath))
+    , m_device(m_ownedFile.get())
 {
     init();
 }
 
 ZipReader::ZipReader(QIODevice *device)
-    : m_reader(new QZipReader(device))
+    : m_device(device)
 {
     init();
 }
 
 ZipReader::~ZipReader()
 {
+    if (m_mappedFile)
+        m_mappedFile->unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
 }
 
+// Maps files and addresses buffers in place; any other device is read through
 void ZipReader::init()
 {
-    const auto &allFiles = m_reader->fileInfoList();
-    for (const auto &fi : allFiles) {
-        if (fi.isFile || (!fi.isDir && !fi.isFile && !fi.isSymLink))
-            m_filePaths.append(fi.filePath);
+    m_open = m_device->isOpen() || m_device->open(QIODevice::ReadOnly);
+    if (!m_open || m_device->isSequential())
+        return;
+
+    m_size = m_device->size();
+    if (QBuffer *buffer = qobject_cast<QBuffer *>(m_device)) {
+        m_data = buffer->data().constData();
+    } else if (QFile *file = qobject_cast<QFile *>(m_device)) {
+        if (m_size > 0) {
+            if (uchar *map = file->map(0, m_size)) {
+                m_data       = reinterpret_cast<const char *>(map);
+                m_mappedFile = file;
+            }
+        }
+    }
+}
+
+void ZipReader::ensureIndex() const
+{
+    if (m_indexed)
+        return;
+    m_indexed = true;
+    m_valid   = m_open && readCentralDirectory();
+    if (!m_valid) {
+        m_entries.clear();
+        m_index.clear();
+        m_filePaths.clear();
     }
 }
 
+/*
+  Finds the end of central directory record, switching to the ZIP64 end
+  record when a locator precedes it, and indexes the entries of the
+  central directory. Sizes and offsets marked as 0xffffffff are taken
+  from the entry's ZIP64 extra field.
+ */
+bool ZipReader::readCentralDirectory() const
+{
+    const qint64 archiveSize = m_data ? m_size : m_device->size();
+    if (archiveSize < kEndOfDirectorySize)
+        return false;
+
+    // The end record is followed by a comment of at most 64 KiB
+    const qint64 tailSize   = qMin<qint64>(archiveSize, kEndOfDirectorySize + 0xffff);
+    const qint64 tailOffset = archiveSize - tailSize;
+    const QByteArray tail   = readAt(tailOffset, tailSize);
+    if (tail.size() != tailSize)
+        return false;
+
+    int endPos = -1;
+    for (int pos = tail.size() - kEndOfDirectorySize; pos >= 0; --pos) {
+        if (readLE32(tail.constData() + pos) == kEndOfDirectorySignature &&
+            pos + kEndOfDirectorySize + readLE16(tail.constData() + pos + 20) <= tail.size()) {
+            endPos = pos;
+            break;
+        }
+    }
+    if (endPos < 0)
+        return false;
+
+    const char *end        = tail.constData() + endPos;
+    quint64 entryCount     = readLE16(end + 10);
+    quint64 directorySize  = readLE32(end + 12);
+    quint64 directoryStart = readLE32(end + 16);
+
+    const qint64 locatorOffset = tailOffset + endPos - kZip64LocatorSize;
+    if (locatorOffset >= 0) {
+        const QByteArray locator = readAt(locatorOffset, kZip64LocatorSize);
+        if (locator.size() == kZip64LocatorSize &&
+            readLE32(locator.constData()) == kZip64LocatorSignature) {
+            const qint64 zip64EndOffset = qint64(readLE64(locator.constData() + 8));
+            const QByteArray zip64End   = readAt(zip64EndOffset, kZip64EndOfDirectorySize);
+            if (zip64End.size() != kZip64EndOfDirectorySize ||
+                readLE32(zip64End.constData()) != kZip64EndOfDirectorySignature)
+                return false;
+            entryCount     = readLE64(zip64End.constData() + 32);
+            directorySize  = readLE64(zip64End.constData() + 40);
+            directoryStart = readLE64(zip64End.constData() + 48);
+        }
+    }
+
+    if (directoryStart + directorySize > quint64(archiveSize) ||
+        directorySize > quint64(std::numeric_limits<int>::max()))
+        return false;
+    const QByteArray directory = readAt(qint64(directoryStart), qint64(directorySize));
+    if (quint64(directory.size()) != directorySize)
+        return false;
+
+    m_entries.reserve(int(qMin<quint64>(entryCount, directorySize / kCentralHeaderSize)));
+    int pos = 0;
+    for (quint64 i = 0; i < entryCount; ++i) {
+        if (pos + kCentralHeaderSize > directory.size())
+            return false;
+        const char *header = directory.constData() + pos;
+        if (readLE32(header) != kCentralHeaderSignature)
+            return false;
+
+        const quint16 flags     = readLE16(header + 8);
+        const int nameLength    = readLE16(header + 28);
+        const int extraLength   = readLE16(header + 30);
+        const int commentLength = readLE16(header + 32);
+        const int recordLength  = kCentralHeaderSize + nameLength + extraLength + commentLength;
+        if (pos + recordLength > directory.size())
+            return false;
+
+        Entry entry;
+        entry.method             = readLE16(header + 10);
+        entry.crc                = readLE32(header + 16);
+        quint64 compressedSize   = readLE32(header + 20);
+        quint64 uncompressedSize = readLE32(header + 24);
+        quint64 headerOffset     = readLE32(header + 42);
+
+        const char *name  = header + kCentralHeaderSize;
+        const char *extra = name + nameLength;
+        for (int e = 0; e + 4 <= extraLength;) {
+            const quint16 id     = readLE16(extra + e);
+            const int size       = readLE16(extra + e + 2);
+            const char *field    = extra + e + 4;
+            const char *fieldEnd = field + qMin(size, extraLength - e - 4);
+            if (id == kZip64ExtraId) {
+                // Only the fields marked in the fixed header are present, in this order
+                if (uncompressedSize == kZip64Marker && field + 8 <= fieldEnd) {
+                    uncompressedSize = readLE64(field);
+                    field += 8;
+                }
+                if (compressedSize == kZip64Marker && field + 8 <= fieldEnd) {
+                    compressedSize = readLE64(field);
+                    field += 8;
+                }
+                if (headerOffset == kZip64Marker && field + 8 <= fieldEnd)
+                    headerOffset = readLE64(field);
+            }
+            e += 4 + size;
+        }
+        entry.compressedSize   = qint64(compressedSize);
+        entry.uncompressedSize = qint64(uncompressedSize);
+        entry.headerOffset     = qint64(headerOffset);
+
+        const QString path = (flags & kUtf8NameFlag) ? QString::fromUtf8(name, nameLength)
+                                                     : QString::fromLocal8Bit(name, nameLength);
+        m_index.insert(path, m_entries.size());
+        m_entries.append(entry);
+        if (!path.endsWith(QLatin1Char('/')))
+            m_filePaths.append(path);
+
+        pos += recordLength;
+    }
+    return true;
+}
+
 bool ZipReader::exists() const
 {
-    return m_reader->exists();
+    ensureIndex();
+    return m_valid;
 }
 
 QStringList ZipReader::filePaths() const
 {
+    ensureIndex();
     return m_filePaths;
 }
 
+/*!
+  Returns the uncompressed size of \a fileName, or -1 if the archive has no
+  such entry.
+ */
+qint64 ZipReader::fileSize(const QString &fileName) const
+{
+    const Entry *entry = findEntry(fileName);
+    return entry ? entry->uncompressedSize : -1;
+}
+
 QByteArray ZipReader::fileData(const QString &fileName) const
 {
-    return m_reader->fileData(fileName);
+    return entryData(fileName, true);
+}
+
+/*!
+  Like fileData(), but a stored entry is returned without copying when the
+  archive is mapped or buffered: the array then refers to the archive's
+  memory and is only valid as long as this reader. Use it for data that is
+  consumed right away.
+ */
+QByteArray ZipReader::fileDataView(const QString &fileName) const
+{
+    return entryData(fileName, false);
+}
+
+QByteArray ZipReader::entryData(const QString &fileName, bool copy) const
+{
+    const Entry *entry = findEntry(fileName);
+    if (!entry)
+        return QByteArray();
+
+    if (entry->uncompressedSize > std::numeric_limits<int>::max() ||
+        entry->compressedSize > std::numeric_limits<int>::max()) {
+        qWarning("ZipReader: %s is too large to be loaded into memory", qPrintable(fileName));
+        return QByteArray();
+    }
+
+    const qint64 offset = dataOffset(*entry);
+    if (offset < 0)
+        return QByteArray();
+    // Refers to the mapping when there is one, so deflated data is read in place
+    const QByteArray compressed = readAt(offset, entry->compressedSize);
+    if (compressed.size() != entry->compressedSize)
+        return QByteArray();
+
+    QByteArray data;
+    if (entry->method == kMethodStored) {
+        data = compressed;
+    } else if (entry->method == kMethodDeflated) {
+        data.resize(int(entry->uncompressedSize));
+        z_stream stream  = z_stream();
+        stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.constData()));
+        stream.avail_in  = uInt(compressed.size());
+        stream.next_out  = reinterpret_cast<Bytef *>(data.data());
+        stream.avail_out = uInt(data.size());
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+            return QByteArray();
+        const int ret = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if (ret != Z_STREAM_END || stream.total_out != uLong(data.size()))
+            data.clear();
+    } else {
+        qWarning("ZipReader: %s uses unsupported compression method %d",
+                 qPrintable(fileName),
+                 entry->method);
+        return QByteArray();
+    }
+
+    const uLong crc = crc32(0, reinterpret_cast<const Bytef *>(data.constData()), uInt(data.size()));
+    if (quint32(crc) != entry->crc) {
+        qWarning("ZipReader: %s is corrupt", qPrintable(fileName));
+        return QByteArray();
+    }
+    if (copy && m_data && entry->method == kMethodStored)
+        data = QByteArray(data.constData(), data.size());
+    return data;
+}
+
+/*!
+  Returns a sequential device that reads \a fileName incrementally, or
+  nullptr if there is no such entry or its compression is unsupported.
+  Only a small chunk of the entry is held in memory at a time. The device
+  must not outlive this reader; a read fails if the data is corrupt.
+ */
+std::unique_ptr<QIODevice> ZipReader::openFile(const QString &fileName) const
+{
+    const Entry *entry = findEntry(fileName);
+    if (!entry)
+        return nullptr;
+
+    const qint64 offset = dataOffset(*entry);
+    if (offset < 0)
+        return nullptr;
+
+    std::unique_ptr<QIODevice> device(new EntryDevice(this, *entry, offset));
+    if (!device->isOpen()) {
+        qWarning("ZipReader: %s uses unsupported compression method %d",
+                 qPrintable(fileName),
+                 entry->method);
+        return nullptr;
+    }
+    return device;
+}
+
+// Offset of the entry's data, past its local header, or -1 if that is invalid
+qint64 ZipReader::dataOffset(const Entry &entry) const
+{
+    const QByteArray localHeader = readAt(entry.headerOffset, kLocalHeaderSize);
+    if (localHeader.size() != kLocalHeaderSize ||
+        readLE32(localHeader.constData()) != kLocalHeaderSignature)
+        return -1;
+    return entry.headerOffset + kLocalHeaderSize + readLE16(localHeader.constData() + 26) +
+           readLE16(localHeader.constData() + 28);
+}
+
+const ZipReader::Entry *ZipReader::findEntry(const QString &fileName) const
+{
+    ensureIndex();
+    const auto it = m_index.constFind(fileName);
+    return it == m_index.constEnd() ? nullptr : &m_entries.at(it.value());
+}
+
+// Returns a view of the mapped or buffered archive, or else reads from the device
+QByteArray ZipReader::readAt(qint64 offset, qint64 size) const
+{
+    if (m_data) {
+        if (offset < 0 || size < 0 || offset > m_size || size > m_size - offset)
+            return QByteArray();
+        return QByteArray::fromRawData(m_data + offset, int(size));
+    }
+    if (!m_open || offset < 0 || !m_device->seek(offset))
+        return QByteArray();
+    return m_device->read(size);
 }
 
 QT_END_NAMESPACE_XLSX
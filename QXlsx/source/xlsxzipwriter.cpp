@@ -1,48 +1,555 @@
 // xlsxzipwriter.cpp
 
 #include "xlsxzipwriter_p.h"
+#include "xlsxparallel_p.h"
 
-#include <private/qzipwriter_p.h>
+#include <cstring>
+#include <functional>
+#include <vector>
 
+#include <zlib.h>
+
+#include <QDateTime>
 #include <QDebug>
+#include <QFile>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+namespace {
+
+const quint32 kLocalHeaderSignature         = 0x04034b50;
+const quint32 kCentralHeaderSignature       = 0x02014b50;
+const quint32 kEndOfDirectorySignature      = 0x06054b50;
+const quint32 kZip64EndOfDirectorySignature = 0x06064b50;
+const quint32 kZip64LocatorSignature        = 0x07064b50;
+const quint32 kDataDescriptorSignature      = 0x08074b50;
+const quint16 kVersionNeeded                = 20; // 2.0, deflate
+const quint16 kVersionZip64                 = 45; // 4.5, ZIP64 extensions
+const quint16 kDataDescriptorFlag           = 0x0008;
+const quint16 kUtf8NameFlag                 = 0x0800;
+const quint16 kMethodStored                 = 0;
+const quint16 kMethodDeflated               = Z_DEFLATED;
+const quint16 kZip64ExtraId                 = 0x0001;
+const quint32 kZip64Marker                  = 0xffffffff; // value moved to a ZIP64 record
+const quint16 kZip64CountMarker             = 0xffff;
+
+void appendLE16(QByteArray &out, quint16 value)
+{
+    out.append(char(value & 0xff));
+    out.append(char(value >> 8));
+}
+
+void appendLE32(QByteArray &out, quint32 value)
+{
+    appendLE16(out, quint16(value & 0xffff));
+    appendLE16(out, quint16(value >> 16));
+}
+
+void appendLE64(QByteArray &out, quint64 value)
+{
+    appendLE32(out, quint32(value & 0xffffffff));
+    appendLE32(out, quint32(value >> 32));
+}
+
+// Appends \a value to a classic 32-bit field, or the marker if it does not fit
+void appendField32(QByteArray &out, quint64 value)
+{
+    appendLE32(out, value >= kZip64Marker ? kZip64Marker : quint32(value));
+}
+
+// Input is deflated in blocks of this size, as in pigz
+const int kBlockSize      = 128 * 1024;
+const int kParallelBlocks = 4; // fewer blocks are not worth the thread hand-off
+const int kDictionarySize = 32 * 1024;
+const int kStreamBatch    = 8 * kBlockSize; // streamed entries deflate this much at once
+
+struct DeflatedBlock {
+    QByteArray data;
+    uLong crc  = 0;
+    int length = 0;
+    bool ok    = false;
+};
+
+/*
+  Deflates \a length bytes of \a input from \a offset on as a piece of one
+  raw deflate stream. The block is primed with the up to 32 KiB before it,
+  so it compresses nearly as well as a single stream would. Blocks other
+  than the \a last end with a sync flush, which leaves the output byte
+  aligned and unterminated, so the pieces can be concatenated as they are.
+ */
+DeflatedBlock deflateBlock(const Bytef *input, int offset, int length, bool last, int level)
+{
+    DeflatedBlock block;
+    block.length = length;
+    block.crc    = crc32(crc32(0, Z_NULL, 0), input + offset, uInt(length));
+
+    z_stream stream = z_stream();
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return block;
+
+    if (offset > 0) {
+        const int dictionary = qMin(kDictionarySize, offset);
+        deflateSetDictionary(&stream, input + offset - dictionary, uInt(dictionary));
+    }
+
+    // Room for the worst case plus the empty stored block of the sync flush
+    block.data.resize(int(deflateBound(&stream, uLong(length))) + 16);
+    stream.next_in   = const_cast<Bytef *>(input + offset);
+    stream.avail_in  = uInt(length);
+    stream.next_out  = reinterpret_cast<Bytef *>(block.data.data());
+    stream.avail_out = uInt(block.data.size());
+    const int ret    = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    block.ok = last ? ret == Z_STREAM_END : (ret == Z_OK && stream.avail_out > 0);
+    block.data.resize(int(stream.total_out));
+    deflateEnd(&stream);
+    return block;
+}
+
+/*
+  Splits the \a size bytes of \a input from \a offset on into blocks and
+  deflates them, in parallel when there are enough of them. The bytes
+  before \a offset only serve as the dictionary of the first block.
+ */
+std::vector<DeflatedBlock> deflateBlocks(
+    const Bytef *input, int offset, int size, bool finish, int level)
+{
+    const int blocks = qMax(1, (size + kBlockSize - 1) / kBlockSize);
+    std::vector<DeflatedBlock> deflated(static_cast<size_t>(blocks));
+    const std::function<void(int)> deflateJob = [&](int i) {
+        const int start     = i * kBlockSize;
+        const int length    = qMin(kBlockSize, size - start);
+        const bool last     = finish && i == blocks - 1;
+        deflated[size_t(i)] = deflateBlock(input, offset + start, length, last, level);
+    };
+    if (blocks < kParallelBlocks) {
+        for (int i = 0; i < blocks; ++i)
+            deflateJob(i);
+    } else {
+        parallelFor(blocks, deflateJob);
+    }
+    return deflated;
+}
+
+bool isAscii(const QByteArray &name)
+{
+    for (char c : name) {
+        if (uchar(c) >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/*
+  The device behind a streamed entry. Written data is collected into
+  batches of a few blocks, which are deflated as one piece of the entry's
+  deflate stream and appended to the archive. The tail of each batch is
+  kept as the dictionary of the next one.
+ */
+class ZipWriter::EntryDevice : public QIODevice
+{
+public:
+    EntryDevice(ZipWriter *writer, int level)
+        : m_writer(writer)
+        , m_level(level)
+    {
+        open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override { return true; }
+
+    // Deflates what is left and terminates the deflate stream.
+    void finish()
+    {
+        deflatePending(true);
+        close();
+    }
+
+    quint32 crc() const { return quint32(m_crc); }
+    qint64 compressedSize() const { return m_compressedSize; }
+    qint64 uncompressedSize() const { return m_uncompressedSize; }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        m_buffer.append(data, int(len));
+        if (m_buffer.size() - m_history >= kStreamBatch)
+            deflatePending(false);
+        return len;
+    }
+
+private:
+    void deflatePending(bool finish)
+    {
+        const Bytef *input = reinterpret_cast<const Bytef *>(m_buffer.constData());
+        const int size     = m_buffer.size() - m_history;
+        const std::vector<DeflatedBlock> deflated =
+            deflateBlocks(input, m_history, size, finish, m_level);
+
+        for (const DeflatedBlock &block : deflated) {
+            if (!block.ok)
+                m_writer->m_error = true;
+            m_crc = crc32_combine(m_crc, block.crc, z_off_t(block.length));
+            m_writer->write(block.data);
+            m_compressedSize += block.data.size();
+            m_uncompressedSize += block.length;
+        }
+
+        const int keep = qMin(kDictionarySize, m_buffer.size());
+        m_buffer.remove(0, m_buffer.size() - keep);
+        m_history = keep;
+    }
+
+    ZipWriter *m_writer;
+    const int m_level;
+    QByteArray m_buffer; // dictionary history followed by pending data
+    int m_history             = 0;
+    uLong m_crc               = crc32(0, Z_NULL, 0);
+    qint64 m_compressedSize   = 0;
+    qint64 m_uncompressedSize = 0;
+};
+
 ZipWriter::ZipWriter(const QString &filePath)
+    : m_file(new QFile(filePath))
+    , m_device(m_file.get())
 {
-    m_writer = new QZipWriter(filePath, QIODevice::WriteOnly);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    if (!m_file->open(QIODevice::WriteOnly))
+        m_error = true;
+    init();
 }
 
 ZipWriter::ZipWriter(QIODevice *device)
+    : m_device(device)
 {
-    m_writer = new QZipWriter(device);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    init();
 }
 
 ZipWriter::~ZipWriter()
 {
-    delete m_writer;
+    close();
+}
+
+// All entries share the time the archive was started
+void ZipWriter::init()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDate date    = now.date();
+    const QTime time    = now.time();
+    m_dosTime = quint16((time.hour() << 11) | (time.minute() << 5) | (time.second() / 2));
+    m_dosDate = quint16((qMax(date.year() - 1980, 0) << 9) | (date.month() << 5) | date.day());
 }
 
 bool ZipWriter::error() const
 {
-    return m_writer->status() != QZipWriter::NoError;
+    return m_error;
+}
+
+/*!
+  Compresses \a data for addFile() at zlib \a level, following \a policy.
+  Data larger than a couple of blocks is deflated block by block on the
+  thread pool. Safe to call from several threads at once.
+ */
+ZipWriter::CompressedEntry ZipWriter::compress(const QByteArray &data,
+                                               int level,
+                                               CompressionPolicy policy)
+{
+    const Bytef *input = reinterpret_cast<const Bytef *>(data.constData());
+    const int size     = data.size();
+
+    CompressedEntry entry;
+    entry.uncompressedSize = size;
+
+    if (policy == NeverCompress || level == 0) {
+        entry.crc  = quint32(crc32(0, input, uInt(size)));
+        entry.data = data;
+        return entry;
+    }
+
+    const std::vector<DeflatedBlock> deflated = deflateBlocks(input, 0, size, true, level);
+
+    int deflatedSize = 0;
+    bool ok          = true;
+    entry.crc        = quint32(crc32(0, Z_NULL, 0));
+    for (const DeflatedBlock &block : deflated) {
+        entry.crc = quint32(crc32_combine(uLong(entry.crc), block.crc, z_off_t(block.length)));
+        deflatedSize += block.data.size();
+        ok = ok && block.ok;
+    }
+
+    if (ok && (policy == AlwaysCompress || deflatedSize < size)) {
+        entry.data.resize(deflatedSize);
+        char *out = entry.data.data();
+        for (const DeflatedBlock &block : deflated) {
+            memcpy(out, block.data.constData(), size_t(block.data.size()));
+            out += block.data.size();
+        }
+        entry.deflated = true;
+        return entry;
+    }
+
+    entry.data = data;
+    return entry;
+}
+
+void ZipWriter::setCompressionLevel(int level)
+{
+    m_level = level;
+}
+
+int ZipWriter::compressionLevel() const
+{
+    return m_level;
+}
+
+void ZipWriter::setCompressionPolicy(CompressionPolicy policy)
+{
+    m_policy = policy;
+}
+
+ZipWriter::CompressionPolicy ZipWriter::compressionPolicy() const
+{
+    return m_policy;
 }
 
 void ZipWriter::addFile(const QString &filePath, QIODevice *device)
 {
-    m_writer->addFile(filePath, device);
+    const bool opened = !device->isOpen();
+    if (opened && !device->open(QIODevice::ReadOnly)) {
+        qWarning("ZipWriter: cannot open %s for reading", qPrintable(filePath));
+        m_error = true;
+        return;
+    }
+    addFile(filePath, device->readAll());
+    if (opened)
+        device->close();
 }
 
 void ZipWriter::addFile(const QString &filePath, const QByteArray &data)
 {
-    m_writer->addFile(filePath, data);
+    addFile(filePath, compress(data, m_level, m_policy));
+}
+
+void ZipWriter::addFile(const QString &filePath, const CompressedEntry &entry)
+{
+    closeFile();
+    if (m_error || m_closed)
+        return;
+
+    DirectoryEntry dirEntry   = newEntry(filePath);
+    dirEntry.method           = entry.deflated ? kMethodDeflated : kMethodStored;
+    dirEntry.crc              = entry.crc;
+    dirEntry.compressedSize   = quint64(entry.data.size());
+    dirEntry.uncompressedSize = quint64(entry.uncompressedSize);
+
+    writeLocalHeader(dirEntry);
+    write(entry.data);
+    m_entries.append(dirEntry);
+}
+
+/*!
+  Starts a streamed entry named \a filePath and returns the device its
+  data is written to. The data is deflated as it arrives, in batches, so
+  only a bounded window of it is held in memory; the CRC and the sizes
+  follow the data in a data descriptor. NeverCompress and level 0 write
+  stored deflate blocks. The device stays valid until closeFile(),
+  addFile() or close() is called.
+ */
+QIODevice *ZipWriter::openFile(const QString &filePath)
+{
+    closeFile();
+    if (m_closed)
+        return nullptr;
+
+    DirectoryEntry dirEntry = newEntry(filePath);
+    dirEntry.flags |= kDataDescriptorFlag;
+    dirEntry.method = kMethodDeflated;
+    writeLocalHeader(dirEntry);
+    m_entries.append(dirEntry);
+
+    const int level = m_policy == NeverCompress ? 0 : m_level;
+    m_entry.reset(new EntryDevice(this, level));
+    return m_entry.get();
+}
+
+/*!
+  Finishes the entry started by openFile(), if any.
+ */
+void ZipWriter::closeFile()
+{
+    if (!m_entry)
+        return;
+
+    std::unique_ptr<EntryDevice> entry = std::move(m_entry);
+    entry->finish();
+
+    DirectoryEntry &dirEntry  = m_entries.last();
+    dirEntry.crc              = entry->crc();
+    dirEntry.compressedSize   = quint64(entry->compressedSize());
+    dirEntry.uncompressedSize = quint64(entry->uncompressedSize());
+
+    // The local header carried a ZIP64 extra field, so the sizes take
+    // 8 bytes each (APPNOTE 4.3.9.2)
+    QByteArray descriptor;
+    appendLE32(descriptor, kDataDescriptorSignature);
+    appendLE32(descriptor, dirEntry.crc);
+    appendLE64(descriptor, dirEntry.compressedSize);
+    appendLE64(descriptor, dirEntry.uncompressedSize);
+    write(descriptor);
+}
+
+ZipWriter::DirectoryEntry ZipWriter::newEntry(const QString &filePath) const
+{
+    DirectoryEntry entry;
+    entry.name         = filePath.toUtf8();
+    entry.flags        = isAscii(entry.name) ? 0 : kUtf8NameFlag;
+    entry.headerOffset = quint64(m_offset);
+    return entry;
+}
+
+void ZipWriter::writeLocalHeader(const DirectoryEntry &entry)
+{
+    // Streamed entries leave the CRC and sizes to their data descriptor.
+    // Their size is not known yet, so they always get a zeroed ZIP64 extra
+    // field, as Info-ZIP and libzip write, which tells readers that the
+    // data descriptor holds 8-byte sizes.
+    const bool streamed = entry.flags & kDataDescriptorFlag;
+    const bool zip64    = streamed || entry.compressedSize >= kZip64Marker ||
+                       entry.uncompressedSize >= kZip64Marker;
+
+    QByteArray header;
+    appendLE32(header, kLocalHeaderSignature);
+    appendLE16(header, zip64 ? kVersionZip64 : kVersionNeeded);
+    appendLE16(header, entry.flags);
+    appendLE16(header, entry.method);
+    appendLE16(header, m_dosTime);
+    appendLE16(header, m_dosDate);
+    appendLE32(header, streamed ? 0 : entry.crc);
+    appendLE32(header, streamed ? 0 : (zip64 ? kZip64Marker : quint32(entry.compressedSize)));
+    appendLE32(header, streamed ? 0 : (zip64 ? kZip64Marker : quint32(entry.uncompressedSize)));
+    appendLE16(header, quint16(entry.name.size()));
+    appendLE16(header, zip64 ? 20 : 0); // extra field length
+    header.append(entry.name);
+    if (zip64) {
+        // A local ZIP64 record holds both sizes, zero until a streamed
+        // entry is finished
+        appendLE16(header, kZip64ExtraId);
+        appendLE16(header, 16);
+        appendLE64(header, streamed ? 0 : entry.uncompressedSize);
+        appendLE64(header, streamed ? 0 : entry.compressedSize);
+    }
+    write(header);
 }
 
 void ZipWriter::close()
 {
-    m_writer->close();
+    if (m_closed)
+        return;
+    closeFile();
+    m_closed = true;
+
+    if (!m_error)
+        writeCentralDirectory();
+
+    if (m_file)
+        m_file->close();
+}
+
+/*
+  Writes the central directory and its end record. Entry fields that do not
+  fit their classic field are marked and moved to a ZIP64 extra field, and
+  the end record is preceded by the ZIP64 end record and locator whenever
+  one of its own fields overflows.
+ */
+void ZipWriter::writeCentralDirectory()
+{
+    const quint64 directoryOffset          = quint64(m_offset);
+    const QVector<DirectoryEntry> &entries = m_entries;
+
+    QByteArray directory;
+    for (const DirectoryEntry &entry : entries) {
+        QByteArray zip64Extra;
+        if (entry.uncompressedSize >= kZip64Marker)
+            appendLE64(zip64Extra, entry.uncompressedSize);
+        if (entry.compressedSize >= kZip64Marker)
+            appendLE64(zip64Extra, entry.compressedSize);
+        if (entry.headerOffset >= kZip64Marker)
+            appendLE64(zip64Extra, entry.headerOffset);
+        const bool zip64 = !zip64Extra.isEmpty();
+        // Streamed entries used ZIP64 in their local header and descriptor
+        const bool streamed   = entry.flags & kDataDescriptorFlag;
+        const quint16 version = zip64 || streamed ? kVersionZip64 : kVersionNeeded;
+
+        appendLE32(directory, kCentralHeaderSignature);
+        appendLE16(directory, version); // version made by
+        appendLE16(directory, version);
+        appendLE16(directory, entry.flags);
+        appendLE16(directory, entry.method);
+        appendLE16(directory, m_dosTime);
+        appendLE16(directory, m_dosDate);
+        appendLE32(directory, entry.crc);
+        appendField32(directory, entry.compressedSize);
+        appendField32(directory, entry.uncompressedSize);
+        appendLE16(directory, quint16(entry.name.size()));
+        appendLE16(directory, zip64 ? quint16(zip64Extra.size() + 4) : 0); // extra field length
+        appendLE16(directory, 0); // comment length
+        appendLE16(directory, 0); // disk number start
+        appendLE16(directory, 0); // internal attributes
+        appendLE32(directory, 0); // external attributes
+        appendField32(directory, entry.headerOffset);
+        directory.append(entry.name);
+        if (zip64) {
+            appendLE16(directory, kZip64ExtraId);
+            appendLE16(directory, quint16(zip64Extra.size()));
+            directory.append(zip64Extra);
+        }
+    }
+
+    const quint64 entryCount    = quint64(entries.size());
+    const quint64 directorySize = quint64(directory.size());
+    if (entryCount >= kZip64CountMarker || directorySize >= kZip64Marker ||
+        directoryOffset >= kZip64Marker) {
+        const quint64 zip64EndOffset = directoryOffset + directorySize;
+        appendLE32(directory, kZip64EndOfDirectorySignature);
+        appendLE64(directory, 44); // size of the rest of this record
+        appendLE16(directory, kVersionZip64); // version made by
+        appendLE16(directory, kVersionZip64);
+        appendLE32(directory, 0); // this disk
+        appendLE32(directory, 0); // disk with the central directory
+        appendLE64(directory, entryCount);
+        appendLE64(directory, entryCount);
+        appendLE64(directory, directorySize);
+        appendLE64(directory, directoryOffset);
+
+        appendLE32(directory, kZip64LocatorSignature);
+        appendLE32(directory, 0); // disk with the ZIP64 end record
+        appendLE64(directory, zip64EndOffset);
+        appendLE32(directory, 1); // total number of disks
+    }
+
+    const quint16 classicCount = quint16(qMin<quint64>(entryCount, kZip64CountMarker));
+    appendLE32(directory, kEndOfDirectorySignature);
+    appendLE16(directory, 0); // this disk
+    appendLE16(directory, 0); // disk with the central directory
+    appendLE16(directory, classicCount);
+    appendLE16(directory, classicCount);
+    appendField32(directory, directorySize);
+    appendField32(directory, directoryOffset);
+    appendLE16(directory, 0); // comment length
+    write(directory);
+}
+
+void ZipWriter::write(const QByteArray &bytes)
+{
+    if (m_error)
+        return;
+    if (m_device->write(bytes) != bytes.size()) {
+        m_error = true;
+        return;
+    }
+    m_offset += bytes.size();
 }
 
 QT_END_NAMESPACE_XLSX
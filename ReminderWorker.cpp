@@ -17,6 +17,9 @@ void ReminderWorker::run()
 
         QThread::sleep(60);
     }
+
+    // 线程即将退出，移除本线程的数据库连接
+    TaskDatabase::getInstance()->releaseThreadConnection();
 }
 
 // 停止线程
@@ -0,0 +1,38 @@
+#include "StartupTrace.h"
+#include <QElapsedTimer>
+#include <QSet>
+#include <QDebug>
+
+namespace {
+QElapsedTimer& startupTimer()
+{
+    static QElapsedTimer timer;
+    return timer;
+}
+
+QSet<QString>& markedStages()
+{
+    static QSet<QString> stages;
+    return stages;
+}
+}
+
+void StartupTrace::start()
+{
+    startupTimer().start();
+    markedStages().clear();
+}
+
+void StartupTrace::mark(const QString& stage)
+{
+    if (!startupTimer().isValid() || markedStages().contains(stage)) {
+        return;
+    }
+    markedStages().insert(stage);
+    qInfo() << "启动跟踪：" << stage << elapsed() << "ms";
+}
+
+qint64 StartupTrace::elapsed()
+{
+    return startupTimer().isValid() ? startupTimer().elapsed() : 0;
+}
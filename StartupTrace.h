@@ -0,0 +1,16 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+
+// 启动耗时跟踪：从 main() 开始计时，记录窗口可用、首行数据显示等阶段
+class StartupTrace
+{
+public:
+    static void start();
+    // 输出阶段名称及距启动的毫秒数，同一阶段只记录一次
+    static void mark(const QString& stage);
+    static qint64 elapsed();
+};
+
+#endif // STARTUPTRACE_H
@@ -1,12 +1,25 @@
 #include "TaskDatabase.h"
 #include <QDir>
+#include <QFileInfo>
 #include <QSqlDatabase>
+#include <QSqlDriver>
 #include <QSqlError>
 #include <QDebug>
 #include <QThread>
+#include <sqlite3.h>
 
 TaskDatabase* TaskDatabase::m_instance = nullptr;
 
+namespace {
+// 每执行这么多条 SQLite 虚拟机指令检查一次取消标志
+const int kCancelCheckInterval = 1000;
+
+int checkCancelled(void* flag)
+{
+    return static_cast<const std::atomic_bool*>(flag)->load(std::memory_order_relaxed) ? 1 : 0;
+}
+}
+
 TaskDatabase::TaskDatabase() : QObject()
 {
 }
@@ -15,7 +28,7 @@ TaskDatabase::~TaskDatabase()
 {
     QStringList connections = QSqlDatabase::connectionNames();
     for (const QString& connection : connections) {
-        if (connection.startsWith("TaskDBConnection_")) {
+        if (connection.startsWith("TaskDB_")) {
             QSqlDatabase::removeDatabase(connection);
         }
     }
@@ -29,8 +42,18 @@ TaskDatabase* TaskDatabase::getInstance()
     return m_instance;
 }
 
+void TaskDatabase::setDatabasePath(const QString& path)
+{
+    m_databasePath = path;
+}
+
 QString TaskDatabase::getDatabasePath()
 {
+    if (!m_databasePath.isEmpty()) {
+        QDir().mkpath(QFileInfo(m_databasePath).absolutePath());
+        return m_databasePath;
+    }
+
     QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
 
     // 确保目录存在且可写
@@ -45,34 +68,38 @@ QString TaskDatabase::getDatabasePath()
     return dbPath;
 }
 
-QSqlDatabase TaskDatabase::createDatabaseConnection()
+QString TaskDatabase::threadConnectionName()
 {
     //使用线程唯一的连接名
-    QString connectionName = "TaskDB_" + QString::number((quintptr)QThread::currentThreadId());
+    return "TaskDB_" + QString::number((quintptr)QThread::currentThreadId());
+}
+
+QSqlDatabase TaskDatabase::createDatabaseConnection()
+{
+    QString connectionName = threadConnectionName();
 
     // 如果连接已存在，直接返回
     if (QSqlDatabase::contains(connectionName)) {
-        QSqlDatabase db = QSqlDatabase::database(connectionName);
-        // 如果连接已关闭，重新打开
-        if (!db.isOpen()) {
-            if (!db.open()) {
-                qCritical() << "重新打开数据库连接失败：" << db.lastError().text();
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if (db.isValid()) {
+            // 如果连接已关闭，重新打开
+            if (!db.isOpen()) {
+                if (!db.open()) {
+                    qCritical() << "重新打开数据库连接失败：" << db.lastError().text();
+                }
             }
+            return db;
         }
-        return db;
+        // 同名连接属于已退出且未释放连接的线程（线程 id 被复用），不能在本线程使用，移除后重建
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
     }
 
     // 连接不存在，创建新连接
     QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
-    QString dbPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/task_manager.db";
+    QString dbPath = getDatabasePath(); // 同时确保目录存在
     db.setDatabaseName(dbPath);
 
-    // 确保目录存在
-    QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
-    if (!dir.exists()) {
-        dir.mkpath(".");
-    }
-
     // 打开数据库并检查
     if (!db.open()) {
         qCritical() << "数据库连接失败：" << db.lastError().text();
@@ -108,6 +135,12 @@ bool TaskDatabase::init()
         return false;
     }
 
+    // WAL 模式：后台导出的读事务与界面写入互不阻塞（设置保存在数据库文件中）
+    QSqlQuery walQuery(db);
+    if (!walQuery.exec("PRAGMA journal_mode=WAL")) {
+        qWarning() << "启用 WAL 模式失败：" << walQuery.lastError().text();
+    }
+
     // 创建分类表
     QString createCategoryTable = R"(
         CREATE TABLE IF NOT EXISTS categories (
@@ -145,6 +178,70 @@ bool TaskDatabase::init()
         return false;
     }
 
+    // 任务表按各列键集分页读取：每个排序键一个 (排序键, id) 索引，
+    // 索引表达式需与 TaskTableModel::sortKeyExpression 一致（id 列直接使用主键）
+    const QStringList sortIndexStatements = {
+        "CREATE INDEX IF NOT EXISTS idx_tasks_deadline ON tasks(IFNULL(deadline, ''), id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_title ON tasks(IFNULL(title, ''), id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_description ON tasks(IFNULL(description, ''), id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_category ON tasks(IFNULL(category_id, 0), id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_priority ON tasks(priority, id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_completed ON tasks(completed, id)",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_create_time ON tasks(create_time, id)"
+    };
+    for (const QString& statement : sortIndexStatements) {
+        QSqlQuery indexQuery(db);
+        if (!indexQuery.exec(statement)) {
+            qWarning() << "创建排序索引失败：" << indexQuery.lastError().text();
+        }
+    }
+
+    // 变更日志：触发器记录每次增删改，增量导出按序号读取，代价与变更数成正比
+    const QStringList changeLogStatements = {
+        R"(
+        CREATE TABLE IF NOT EXISTS task_changes (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            task_id INTEGER NOT NULL,
+            operation TEXT NOT NULL,
+            changed_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP
+        )
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_tasks_insert AFTER INSERT ON tasks
+        BEGIN
+            INSERT INTO task_changes (task_id, operation) VALUES (NEW.id, 'I');
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_tasks_update AFTER UPDATE ON tasks
+        BEGIN
+            INSERT INTO task_changes (task_id, operation) VALUES (NEW.id, 'U');
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS trg_tasks_delete AFTER DELETE ON tasks
+        BEGIN
+            INSERT INTO task_changes (task_id, operation) VALUES (OLD.id, 'D');
+        END
+        )",
+        // 各导出方已导出到的变更序号（高水位）
+        R"(
+        CREATE TABLE IF NOT EXISTS export_watermarks (
+            consumer TEXT PRIMARY KEY,
+            seq INTEGER NOT NULL,
+            exported_at DATETIME NOT NULL DEFAULT CURRENT_TIMESTAMP
+        )
+        )"
+    };
+    for (const QString& statement : changeLogStatements) {
+        QSqlQuery changeLogQuery(db);
+        if (!executeQuery(changeLogQuery, statement)) {
+            qCritical() << "创建变更日志失败";
+            db.close();
+            return false;
+        }
+    }
+
     // 插入默认分类
     QSqlQuery checkQuery("SELECT COUNT(*) FROM categories", db);
     if (checkQuery.next() && checkQuery.value(0).toInt() == 0) {
@@ -492,7 +589,112 @@ QMap<TaskPriority, int> TaskDatabase::getTaskCountByPriority()
     return countMap;
 }
 
+// 变更日志与导出高水位
+qint64 TaskDatabase::getLatestChangeSeq()
+{
+    QSqlDatabase db = createDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "读取变更序号失败：数据库未打开";
+        return 0;
+    }
+    // 已导出的变更会被清理，最大序号以 AUTOINCREMENT 记录的为准，清空后也不会回退
+    QSqlQuery query(R"(
+        SELECT MAX(IFNULL((SELECT seq FROM sqlite_sequence WHERE name = 'task_changes'), 0),
+                   IFNULL((SELECT MAX(seq) FROM task_changes), 0))
+    )", db);
+    return query.next() ? query.value(0).toLongLong() : 0;
+}
+
+qint64 TaskDatabase::getExportWatermark(const QString& consumer)
+{
+    QSqlDatabase db = createDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "读取导出高水位失败：数据库未打开";
+        return -1;
+    }
+    QSqlQuery query(db);
+    query.prepare("SELECT seq FROM export_watermarks WHERE consumer = :consumer");
+    query.bindValue(":consumer", consumer);
+    if (!query.exec()) {
+        qCritical() << "读取导出高水位失败：" << query.lastError().text();
+        return -1;
+    }
+    return query.next() ? query.value(0).toLongLong() : -1;
+}
+
+bool TaskDatabase::setExportWatermark(const QString& consumer, qint64 seq)
+{
+    QSqlDatabase db = createDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "记录导出高水位失败：数据库未打开";
+        return false;
+    }
+    QSqlQuery query(db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO export_watermarks (consumer, seq, exported_at)
+        VALUES (:consumer, :seq, CURRENT_TIMESTAMP)
+    )");
+    query.bindValue(":consumer", consumer);
+    query.bindValue(":seq", seq);
+    if (!query.exec()) {
+        qCritical() << "记录导出高水位失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool TaskDatabase::pruneExportedChanges()
+{
+    QSqlDatabase db = createDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "清理变更日志失败：数据库未打开";
+        return false;
+    }
+    // 没有任何导出方时 MIN 为 NULL，不删除
+    QSqlQuery query(db);
+    if (!query.exec("DELETE FROM task_changes WHERE seq <= (SELECT MIN(seq) FROM export_watermarks)")) {
+        qCritical() << "清理变更日志失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
 QSqlDatabase TaskDatabase::getDatabaseConnection()
 {
     return createDatabaseConnection();
 }
+
+void TaskDatabase::releaseThreadConnection()
+{
+    const QString connectionName = threadConnectionName();
+    if (!QSqlDatabase::contains(connectionName)) {
+        return;
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QueryCancelScope::QueryCancelScope(const QSqlDatabase& db, const std::atomic_bool* cancelled)
+{
+    // QSQLITE 驱动的原生句柄类型名为 "sqlite3*"
+    const QVariant handle = db.driver() ? db.driver()->handle() : QVariant();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) {
+        return;
+    }
+    m_handle = *static_cast<sqlite3* const*>(handle.constData());
+    if (m_handle) {
+        // 进度回调只在执行语句的本线程调用，取消标志由界面线程写入
+        sqlite3_progress_handler(m_handle, kCancelCheckInterval, &checkCancelled,
+                                 const_cast<std::atomic_bool*>(cancelled));
+    }
+}
+
+QueryCancelScope::~QueryCancelScope()
+{
+    if (m_handle) {
+        sqlite3_progress_handler(m_handle, 0, nullptr, nullptr);
+    }
+}
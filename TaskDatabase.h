@@ -9,6 +9,9 @@
 #include <QVariant>
 #include <QDebug>
 #include <QStandardPaths>
+#include <atomic>
+
+struct sqlite3;
 
 // 任务优先级枚举
 enum TaskPriority {
@@ -42,6 +45,11 @@ public:
     static TaskDatabase* getInstance();
     ~TaskDatabase();
     QSqlDatabase getDatabaseConnection();
+    // 关闭并移除当前线程的连接：即将退出的线程在最后调用，调用前本线程不能再持有任何 QSqlDatabase/QSqlQuery
+    void releaseThreadConnection();
+
+    // 指定数据库文件（默认在应用数据目录下），须在第一次连接数据库之前调用
+    void setDatabasePath(const QString& path);
 
     // 初始化数据库（创建表）
     bool init();
@@ -68,13 +76,48 @@ public:
     QMap<QString, int> getTaskCountByCategory();
     QMap<TaskPriority, int> getTaskCountByPriority();
 
+    // 变更日志（由触发器写入 task_changes）与增量导出高水位
+    qint64 getLatestChangeSeq();
+    // 未记录过的导出方返回 -1
+    qint64 getExportWatermark(const QString& consumer);
+    bool setExportWatermark(const QString& consumer, qint64 seq);
+    // 删除所有导出方都已导出过的变更（序号不超过最低高水位）
+    bool pruneExportedChanges();
+
 private:
     TaskDatabase();
     static TaskDatabase* m_instance;
+    QString m_databasePath;
     // 私有辅助方法
+    static QString threadConnectionName();
     QSqlDatabase createDatabaseConnection();
     bool executeQuery(QSqlQuery &query, const QString &queryString);
     QString getDatabasePath();
 };
 
+// 线程池任务在函数开头声明：任务返回时（此前声明的连接、查询都已析构）关闭并移除本线程的连接。
+// 池线程空闲一段时间就会退出，线程 id 可能被新线程复用，连接不能留给下一个任务
+class ThreadConnectionScope
+{
+public:
+    ThreadConnectionScope() = default;
+    ~ThreadConnectionScope() { TaskDatabase::getInstance()->releaseThreadConnection(); }
+    ThreadConnectionScope(const ThreadConnectionScope&) = delete;
+    ThreadConnectionScope& operator=(const ThreadConnectionScope&) = delete;
+};
+
+// 后台查询在执行前声明：SQLite 执行语句期间定期检查取消标志，置位后以 SQLITE_INTERRUPT 中止当前语句，
+// 不必等 exec()/next() 返回到下一行才发现取消。作用域结束时移除检查
+class QueryCancelScope
+{
+public:
+    QueryCancelScope(const QSqlDatabase& db, const std::atomic_bool* cancelled);
+    ~QueryCancelScope();
+    QueryCancelScope(const QueryCancelScope&) = delete;
+    QueryCancelScope& operator=(const QueryCancelScope&) = delete;
+
+private:
+    sqlite3* m_handle = nullptr;
+};
+
 #endif // TASKDATABASE_H
@@ -11,20 +11,37 @@ QXLSX_ROOT = $$PWD/QXlsx
 include($$QXLSX_ROOT/QXlsx.pri)
 # -------------------------------------------------------
 
+# 后台查询通过 QSqlDriver::handle() 注册 SQLite 进度回调以便中途取消；
+# 需与 Qt 的 QSQLITE 驱动使用同一份 SQLite（Qt 以 -system-sqlite 构建）
+LIBS += -lsqlite3
+
+
 SOURCES += \
+    ExportJob.cpp \
     ExportManager.cpp \
+    ExportSinks.cpp \
+    PdfReportRenderer.cpp \
     ReminderWorker.cpp \
+    StartupTrace.cpp \
     TaskDatabase.cpp \
-    TaskModel.cpp \
+    TaskSearchEngine.cpp \
+    TaskTableModel.cpp \
+    XlsxStreamWriter.cpp \
     main.cpp \
     MainWindow.cpp \
 
 HEADERS += \
     MainWindow.h \
+    PdfReportRenderer.h \
     ReminderWorker.h \
+    StartupTrace.h \
+    ExportJob.h \
     ExportManager.h \
+    ExportSinks.h \
     TaskDatabase.h \
-    TaskModel.h
+    TaskSearchEngine.h \
+    TaskTableModel.h \
+    XlsxStreamWriter.h
 
 FORMS += \
     MainWindow.ui
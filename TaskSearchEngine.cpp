@@ -0,0 +1,146 @@
+#include "TaskSearchEngine.h"
+#include "TaskTableModel.h"
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+TaskSearchEngine::TaskSearchEngine(QObject *parent)
+    : QObject(parent)
+{
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(250);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &TaskSearchEngine::startQuery);
+}
+
+TaskSearchEngine::~TaskSearchEngine()
+{
+    // 后台查询不引用本对象，置取消标志后即可安全析构
+    cancel();
+}
+
+void TaskSearchEngine::setDebounceInterval(int msecs)
+{
+    m_debounceTimer.setInterval(msecs);
+}
+
+void TaskSearchEngine::search(const QString& text)
+{
+    m_pendingText = text;
+
+    // 清空搜索不需要查询，立即恢复全部显示
+    if (text.isEmpty()) {
+        m_debounceTimer.stop();
+        cancel();
+        ++m_generation;
+        emit resultsReady(text, IdList());
+        return;
+    }
+
+    m_debounceTimer.start();
+}
+
+void TaskSearchEngine::cancel()
+{
+    if (m_token) {
+        m_token->store(true);
+        m_token.reset();
+    }
+    if (m_running) {
+        m_running = false;
+        m_metrics.cancelled++;
+    }
+}
+
+void TaskSearchEngine::startQuery()
+{
+    cancel();
+
+    const quint64 generation = ++m_generation;
+    CancelToken token = std::make_shared<std::atomic_bool>(false);
+    m_token = token;
+    m_running = true;
+    m_metrics.started++;
+    m_latencyTimer.start();
+
+    auto* watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        finishQuery(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&TaskSearchEngine::runQuery, generation, m_pendingText, token));
+}
+
+void TaskSearchEngine::finishQuery(const Result& result)
+{
+    // 已被新查询取代（或已取消）的结果直接丢弃
+    if (result.generation != m_generation || result.cancelled) {
+        if (!result.cancelled) {
+            m_metrics.dropped++;
+            emit metricsChanged(m_metrics);
+        }
+        return;
+    }
+
+    m_running = false;
+    m_token.reset();
+
+    const qint64 latency = m_latencyTimer.elapsed();
+    m_metrics.completed++;
+    m_metrics.lastLatencyMs = latency;
+    m_metrics.maxLatencyMs = qMax(m_metrics.maxLatencyMs, latency);
+    m_metrics.totalLatencyMs += latency;
+
+    emit resultsReady(result.text, result.ids);
+    emit metricsChanged(m_metrics);
+}
+
+TaskSearchEngine::Result TaskSearchEngine::runQuery(quint64 generation, const QString& text, CancelToken token)
+{
+    // 本线程的连接只在这次搜索中使用，返回时移除
+    ThreadConnectionScope connectionScope;
+
+    Result result;
+    result.generation = generation;
+    result.text = text;
+
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "搜索任务失败：数据库未打开";
+        result.ids = std::make_shared<const QVector<int>>();
+        return result;
+    }
+
+    // 匹配条件与任务模型的文本过滤共用同一段 SQL，只把命中的 id 读回来
+    TaskFilter filter;
+    filter.text = text;
+    QVariantList values;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT t.id FROM tasks t WHERE " + filter.sqlCondition(&values) + " ORDER BY t.id");
+    for (const QVariant& value : std::as_const(values)) {
+        query.addBindValue(value);
+    }
+    // 输入变化后 SQLite 在语句执行中途即中止，尽快让出线程
+    QueryCancelScope cancelScope(db, token.get());
+    if (!query.exec()) {
+        if (token->load()) {
+            result.cancelled = true;
+            return result;
+        }
+        qCritical() << "搜索任务失败：" << query.lastError().text();
+        result.ids = std::make_shared<const QVector<int>>();
+        return result;
+    }
+
+    auto ids = std::make_shared<QVector<int>>();
+    while (query.next()) {
+        ids->append(query.value(0).toInt());
+    }
+    // 被中断的语句 next() 提前返回 false，结果不完整
+    if (token->load()) {
+        result.cancelled = true;
+        return result;
+    }
+
+    result.ids = std::move(ids);
+    return result;
+}
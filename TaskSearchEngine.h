@@ -0,0 +1,70 @@
+#ifndef TASKSEARCHENGINE_H
+#define TASKSEARCHENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+
+// 搜索统计：延迟从查询启动计到结果交给界面
+struct SearchMetrics {
+    int started = 0;     // 已启动的查询数
+    int completed = 0;   // 结果已交付的查询数
+    int cancelled = 0;   // 被新输入取消的查询数
+    int dropped = 0;     // 完成时已过期而被丢弃的结果数
+    qint64 lastLatencyMs = 0;
+    qint64 maxLatencyMs = 0;
+    qint64 totalLatencyMs = 0;
+
+    double averageLatencyMs() const { return completed ? double(totalLatencyMs) / completed : 0.0; }
+};
+
+// 后台任务搜索：输入防抖，匹配条件交给 SQL 在线程池中执行，新输入会取消旧查询，
+// 过期查询的结果直接丢弃，只有最后一次查询的命中 id 列表会交给界面
+class TaskSearchEngine : public QObject
+{
+    Q_OBJECT
+public:
+    using CancelToken = std::shared_ptr<std::atomic_bool>;
+    using IdList = std::shared_ptr<const QVector<int>>; // 升序排列的任务 id
+
+    explicit TaskSearchEngine(QObject *parent = nullptr);
+    ~TaskSearchEngine() override;
+
+    void setDebounceInterval(int msecs);
+    const SearchMetrics& metrics() const { return m_metrics; }
+
+public slots:
+    void search(const QString& text);
+    void cancel();
+
+signals:
+    // ids 为空指针表示没有搜索条件（显示全部）
+    void resultsReady(const QString& text, TaskSearchEngine::IdList ids);
+    void metricsChanged(const SearchMetrics& metrics);
+
+private:
+    struct Result {
+        quint64 generation = 0;
+        QString text;
+        IdList ids;
+        bool cancelled = false;
+    };
+
+    void startQuery();
+    void finishQuery(const Result& result);
+    static Result runQuery(quint64 generation, const QString& text, CancelToken token);
+
+    QTimer m_debounceTimer;
+    QString m_pendingText;
+    quint64 m_generation = 0;
+    CancelToken m_token;
+    bool m_running = false;
+    QElapsedTimer m_latencyTimer;
+    SearchMetrics m_metrics;
+};
+
+#endif // TASKSEARCHENGINE_H
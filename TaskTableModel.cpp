@@ -0,0 +1,1070 @@
+#include "TaskTableModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QSet>
+#include <algorithm>
+#include <utility>
+
+bool TaskFilter::isEmpty() const
+{
+    return categoryId < 0 && priority < 0 && completed < 0
+           && deadlineFrom < 0 && deadlineTo < 0 && text.isEmpty();
+}
+
+QString TaskFilter::sqlCondition(QVariantList* values) const
+{
+    QStringList conditions;
+    if (categoryId >= 0) {
+        conditions.append("IFNULL(t.category_id, 0) = ?");
+        values->append(categoryId);
+    }
+    if (priority >= 0) {
+        conditions.append("t.priority = ?");
+        values->append(priority);
+    }
+    if (completed >= 0) {
+        conditions.append("t.completed = ?");
+        values->append(completed != 0);
+    }
+    // 截止时间与写入时一样按 QDateTime 绑定，比较的是同一格式的文本；无截止时间的行不通过
+    if (deadlineFrom >= 0) {
+        conditions.append("t.deadline >= ?");
+        values->append(QDateTime::fromMSecsSinceEpoch(deadlineFrom));
+    }
+    if (deadlineTo >= 0) {
+        conditions.append("t.deadline <= ?");
+        values->append(QDateTime::fromMSecsSinceEpoch(deadlineTo));
+    }
+    // 没有后台搜索结果时直接在 SQL 中匹配（lower() 只折叠 ASCII，中文不受影响）。
+    // 匹配范围与表格显示的文本一致：标题、描述、分类名、优先级、完成状态，字段间以换行分隔，不会跨字段命中
+    if (!text.isEmpty() && !matchingIds) {
+        conditions.append("instr(lower(t.title || char(10) || IFNULL(t.description, '') || char(10)"
+                          " || IFNULL((SELECT c.name FROM categories c WHERE c.id = t.category_id), ?) || char(10)"
+                          " || CASE t.priority WHEN 0 THEN ? WHEN 1 THEN ? WHEN 2 THEN ? ELSE ? END || char(10)"
+                          " || CASE WHEN t.completed THEN ? ELSE ? END), lower(?)) > 0");
+        values->append(TaskTableModel::tr("未分类"));
+        values->append(TaskTableModel::tr("低"));
+        values->append(TaskTableModel::tr("中"));
+        values->append(TaskTableModel::tr("高"));
+        values->append(TaskTableModel::tr("未知"));
+        values->append(TaskTableModel::tr("已完成"));
+        values->append(TaskTableModel::tr("未完成"));
+        values->append(text);
+    }
+    return conditions.join(" AND ");
+}
+
+bool TaskFilter::narrows(const TaskFilter& other) const
+{
+    auto narrowsValue = [](int value, int otherValue) {
+        return otherValue < 0 || value == otherValue;
+    };
+    if (!narrowsValue(categoryId, other.categoryId) || !narrowsValue(priority, other.priority)
+        || !narrowsValue(completed, other.completed)) {
+        return false;
+    }
+    if (other.deadlineFrom >= 0 && (deadlineFrom < 0 || deadlineFrom < other.deadlineFrom)) {
+        return false;
+    }
+    if (other.deadlineTo >= 0 && (deadlineTo < 0 || deadlineTo > other.deadlineTo)) {
+        return false;
+    }
+    // 文本按子串匹配：包含原文本的新文本命中的行也命中原文本；文本不变时搜索结果须是同一份
+    if (text == other.text) {
+        return matchingIds == other.matchingIds;
+    }
+    return other.text.isEmpty() || text.contains(other.text);
+}
+
+bool TaskFilter::operator==(const TaskFilter& other) const
+{
+    return categoryId == other.categoryId && priority == other.priority
+           && completed == other.completed && deadlineFrom == other.deadlineFrom
+           && deadlineTo == other.deadlineTo && text == other.text
+           && matchingIds == other.matchingIds;
+}
+
+void TaskTableModel::Columns::reserve(int rows)
+{
+    ids.reserve(rows);
+    titles.reserve(rows);
+    descriptions.reserve(rows);
+    categorySlots.reserve(rows);
+    priorities.reserve(rows);
+    deadlines.reserve(rows);
+    createTimes.reserve(rows);
+    completed.resize(rows);
+}
+
+TaskTableModel::TaskTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    m_priorityTexts = { tr("低"), tr("中"), tr("高") };
+    m_completedText = tr("已完成");
+    m_pendingText = tr("未完成");
+}
+
+TaskTableModel::~TaskTableModel()
+{
+    // 后台查询不引用本对象，置取消标志即可
+    cancelRowOrderQuery();
+}
+
+int TaskTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_totalRows;
+}
+
+int TaskTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TaskTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_totalRows) {
+        return QVariant();
+    }
+
+    // 页未载入时在后台读取，先显示占位内容，不在界面线程等待查询
+    int row = 0;
+    const Columns* columns = columnsForRow(index.row(), &row, false);
+    if (!columns) {
+        if (role == Qt::DisplayRole && index.column() == TitleColumn
+            && m_loadingPages.contains(index.row() / PageSize)) {
+            return tr("加载中…");
+        }
+        return QVariant();
+    }
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case IdColumn: return columns->ids[row];
+        case TitleColumn: return columns->strings[columns->titles[row]];
+        case DescriptionColumn: return columns->descriptions[row];
+        case CategoryColumn: return m_categoryNames[columns->categorySlots[row]];
+        case PriorityColumn: {
+            quint8 priority = columns->priorities[row];
+            return priority < m_priorityTexts.size() ? m_priorityTexts[priority] : tr("未知");
+        }
+        case DeadlineColumn: {
+            QString& text = columns->deadlineTexts[row];
+            if (text.isNull()) {
+                text = formatDateTime(columns->deadlines[row]);
+            }
+            return text;
+        }
+        case CompletedColumn: return columns->completed.testBit(row) ? m_completedText : m_pendingText;
+        case CreateTimeColumn: {
+            QString& text = columns->createTimeTexts[row];
+            if (text.isNull()) {
+                text = formatDateTime(columns->createTimes[row]);
+            }
+            return text;
+        }
+        default: return QVariant();
+        }
+    }
+
+    // 已完成项灰色
+    if (role == Qt::ForegroundRole && index.column() == CompletedColumn) {
+        static const QBrush completedBrush(QColor(128, 128, 128));
+        return columns->completed.testBit(row) ? QVariant(completedBrush) : QVariant();
+    }
+
+    switch (role) {
+    case TaskIdRole: return columns->ids[row];
+    case CategoryIdRole: return m_categoryIds[columns->categorySlots[row]];
+    case PriorityRole: return int(columns->priorities[row]);
+    case CompletedRole: return columns->completed.testBit(row);
+    case DeadlineRole: return columns->deadlines[row];
+    case CreateTimeRole: return columns->createTimes[row];
+    default: return QVariant();
+    }
+}
+
+QVariant TaskTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+        case IdColumn: return "ID";
+        case TitleColumn: return "任务标题";
+        case DescriptionColumn: return "任务描述";
+        case CategoryColumn: return "分类";
+        case PriorityColumn: return "优先级";
+        case DeadlineColumn: return "截止时间";
+        case CompletedColumn: return "完成状态";
+        case CreateTimeColumn: return "创建时间";
+        default: break;
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+void TaskTableModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= ColumnCount) {
+        return;
+    }
+
+    beginResetModel();
+    m_sortColumn = column;
+    m_sortOrder = order;
+    clearPages();
+    // 有过滤条件时在后台按新顺序重新查询，结果到达前保持当前行
+    if (m_filter.isEmpty()) {
+        loadUnfilteredRows(false);
+    } else {
+        startRowOrderQuery();
+    }
+    endResetModel();
+}
+
+bool TaskTableModel::select()
+{
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "加载任务失败：数据库未打开";
+        return false;
+    }
+
+    beginResetModel();
+    clearPages();
+
+    setCategories(TaskDatabase::getInstance()->getAllCategories());
+    markCollatedOrdersStale();
+
+    bool success = true;
+    if (m_filter.isEmpty()) {
+        success = loadUnfilteredRows(true);
+    } else {
+        startRowOrderQuery();
+    }
+
+    endResetModel();
+    return success;
+}
+
+void TaskTableModel::setFilter(const TaskFilter& filter)
+{
+    if (filter == m_filter) {
+        return;
+    }
+    // 当前 id 列表是旧条件的完整结果且新条件只是收紧时，在现有行中筛选，不再重新查询排序
+    const bool narrowing = m_useRowIds && m_rowIdsMatchFilter && filter.narrows(m_filter);
+    const TaskFilter previous = m_filter;
+    m_filter = filter;
+
+    if (!m_filter.isEmpty()) {
+        if (!narrowing || !narrowRowIdsInPlace(previous)) {
+            startRowOrderQuery(narrowing);
+        }
+        return;
+    }
+
+    beginResetModel();
+    clearPages();
+    loadUnfilteredRows(false);
+    endResetModel();
+}
+
+bool TaskTableModel::loadUnfilteredRows(bool recount)
+{
+    // 无过滤条件：丢弃尚未返回的过滤查询
+    cancelRowOrderQuery();
+
+    if (isCollatedSort()) {
+        // 排过的列直接复用排列（升降序只是反向读取）
+        auto it = m_collatedOrders.constFind(m_sortColumn);
+        if (it != m_collatedOrders.constEnd() && it->keys && !it->stale) {
+            m_rowIds = it->ids;
+            if (m_sortOrder == Qt::DescendingOrder) {
+                std::reverse(m_rowIds.begin(), m_rowIds.end());
+            }
+            m_useRowIds = true;
+            m_rowIdsMatchFilter = true;
+            m_totalRows = m_rowIds.size();
+            return true;
+        }
+        // 排列在后台（增量）生成；生成前或生成失败时按数据库中的原始值分页，行数照常统计
+        startRowOrderQuery();
+    }
+
+    // 键集分页只需行数；从 id 列表切回时行数已变，需要重新统计
+    const bool hadRowIds = m_useRowIds;
+    m_useRowIds = false;
+    m_rowIds.clear();
+    m_rowIdsMatchFilter = false;
+    if (!recount && !hadRowIds) {
+        return true;
+    }
+
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    QSqlQuery countQuery("SELECT COUNT(*) FROM tasks", db);
+    const bool success = countQuery.next();
+    m_totalRows = success ? countQuery.value(0).toInt() : 0;
+    if (!success) {
+        qCritical() << "统计任务失败：" << countQuery.lastError().text();
+    }
+    return success;
+}
+
+bool TaskTableModel::narrowRowIdsInPlace(const TaskFilter& previous)
+{
+    // 只有搜索文本变化时，新结果就是现有行与搜索命中 id 的交集，直接在内存中筛选
+    const TaskFilter& filter = m_filter;
+    if (!filter.matchingIds || filter.categoryId != previous.categoryId || filter.priority != previous.priority
+        || filter.completed != previous.completed || filter.deadlineFrom != previous.deadlineFrom
+        || filter.deadlineTo != previous.deadlineTo) {
+        return false;
+    }
+
+    cancelRowOrderQuery();
+    const QVector<int>& matching = *filter.matchingIds;
+    beginResetModel();
+    clearPages();
+    auto end = std::remove_if(m_rowIds.begin(), m_rowIds.end(), [&matching](int id) {
+        return !std::binary_search(matching.cbegin(), matching.cend(), id);
+    });
+    m_rowIds.erase(end, m_rowIds.end());
+    m_totalRows = m_rowIds.size();
+    endResetModel();
+    return true;
+}
+
+void TaskTableModel::startRowOrderQuery(bool narrowCurrentRows)
+{
+    cancelRowOrderQuery();
+
+    RowOrderRequest request;
+    request.generation = m_rowOrderGeneration;
+    request.filter = m_filter;
+    request.sortColumn = m_sortColumn;
+    request.sortOrder = m_sortOrder;
+    request.collated = isCollatedSort();
+    request.dataVersion = m_dataVersion;
+    if (narrowCurrentRows) {
+        request.narrowing = true;
+        request.candidates = m_rowIds;
+    }
+    m_rowIdsMatchFilter = false;
+    if (request.collated && !request.narrowing) {
+        request.collatedOrder = m_collatedOrders.value(m_sortColumn);
+        request.rebuildOrder = !request.collatedOrder.keys || request.collatedOrder.stale;
+        for (int slot = 1; slot < m_categoryIds.size(); ++slot) {
+            request.categoryNames.insert(m_categoryIds[slot], m_categoryNames[slot]);
+        }
+        request.uncategorizedName = m_categoryNames.value(0);
+    }
+
+    CancelToken token = std::make_shared<std::atomic_bool>(false);
+    m_rowOrderToken = token;
+
+    auto* watcher = new QFutureWatcher<RowOrder>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        installRowOrder(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&TaskTableModel::readRowOrder, request, token));
+}
+
+void TaskTableModel::cancelRowOrderQuery()
+{
+    ++m_rowOrderGeneration;
+    if (m_rowOrderToken) {
+        m_rowOrderToken->store(true);
+        m_rowOrderToken.reset();
+    }
+}
+
+TaskTableModel::RowOrder TaskTableModel::readRowOrder(const RowOrderRequest& request, CancelToken token)
+{
+    // 本线程的连接只在这次查询中使用，返回时移除
+    ThreadConnectionScope connectionScope;
+
+    RowOrder result;
+    result.generation = request.generation;
+    result.sortColumn = request.sortColumn;
+    result.dataVersion = request.dataVersion;
+
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "过滤任务失败：数据库未打开";
+        return result;
+    }
+    // 被新的过滤或排序取代后，SQLite 在语句执行中途即中止
+    QueryCancelScope cancelScope(db, token.get());
+
+    if (request.collated && request.rebuildOrder && !request.narrowing) {
+        if (!buildCollatedOrder(db, request, &result.collatedOrder, token)) {
+            result.cancelled = token->load();
+            return result;
+        }
+        result.orderRebuilt = true;
+    }
+
+    QVariantList values;
+    const QString condition = request.filter.sqlCondition(&values);
+    const QVector<int>* matching = request.filter.matchingIds.get();
+    auto isMatching = [matching](int id) {
+        return !matching || std::binary_search(matching->cbegin(), matching->cend(), id);
+    };
+
+    // 按数据库排序的列直接由 SQL 给出显示顺序；标题、分类排序只取通过条件的 id，
+    // 再按完整排列的顺序保留；收紧条件时同样只取 id，按上次结果的顺序保留
+    const bool sqlOrder = !request.collated && !request.narrowing;
+    QSet<int> accepted;
+    if (sqlOrder || !condition.isEmpty()) {
+        QString sql = "SELECT t.id FROM tasks t";
+        if (!condition.isEmpty()) {
+            sql += " WHERE " + condition;
+        }
+        if (sqlOrder) {
+            const QString direction = request.sortOrder == Qt::AscendingOrder ? "ASC" : "DESC";
+            sql += QString(" ORDER BY %1 %2, t.id %2").arg(sortKeyExpression(request.sortColumn), direction);
+        }
+
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare(sql);
+        for (const QVariant& value : std::as_const(values)) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            result.cancelled = token->load();
+            if (!result.cancelled) {
+                qCritical() << "过滤任务失败：" << query.lastError().text();
+            }
+            return result;
+        }
+
+        while (query.next()) {
+            if (token->load(std::memory_order_relaxed)) {
+                result.cancelled = true;
+                return result;
+            }
+            const int id = query.value(0).toInt();
+            if (!isMatching(id)) {
+                continue;
+            }
+            if (sqlOrder) {
+                result.ids.append(id);
+            } else {
+                accepted.insert(id);
+            }
+        }
+        // 被中断的语句 next() 提前返回 false，结果不完整
+        if (token->load()) {
+            result.cancelled = true;
+            return result;
+        }
+    }
+
+    auto keep = [&](int id) {
+        return condition.isEmpty() ? isMatching(id) : accepted.contains(id);
+    };
+    if (request.narrowing) {
+        for (int id : request.candidates) {
+            if (keep(id)) {
+                result.ids.append(id);
+            }
+        }
+    } else if (request.collated) {
+        const QVector<int>& order = result.orderRebuilt ? result.collatedOrder.ids : request.collatedOrder.ids;
+        const bool ascending = request.sortOrder == Qt::AscendingOrder;
+        for (int i = 0; i < order.size(); ++i) {
+            const int id = order[ascending ? i : order.size() - 1 - i];
+            if (keep(id)) {
+                result.ids.append(id);
+            }
+        }
+    }
+
+    result.success = true;
+    return result;
+}
+
+void TaskTableModel::installRowOrder(const RowOrder& order)
+{
+    // 重排好的排列只要数据没有再刷新就缓存下来，即使这次的行序已被取代
+    if (order.orderRebuilt && order.dataVersion == m_dataVersion) {
+        m_collatedOrders.insert(order.sortColumn, order.collatedOrder);
+    }
+
+    // 已被新的过滤或排序取代的结果直接丢弃
+    if (order.generation != m_rowOrderGeneration || order.cancelled) {
+        return;
+    }
+    m_rowOrderToken.reset();
+    // 失败时保持当前的行与行数（键集分页或上一次的 id 列表）
+    if (!order.success) {
+        return;
+    }
+
+    beginResetModel();
+    clearPages();
+    m_useRowIds = true;
+    m_rowIds = order.ids;
+    m_rowIdsMatchFilter = true;
+    m_totalRows = m_rowIds.size();
+    endResetModel();
+}
+
+void TaskTableModel::selectAsync()
+{
+    // 标题、分类排序需要整列排序键，有过滤条件时需要查询 id 列表，仍走 select()
+    if (isCollatedSort() || !m_filter.isEmpty()) {
+        select();
+        emit firstRowsLoaded();
+        return;
+    }
+
+    const int sortColumn = m_sortColumn;
+    const Qt::SortOrder sortOrder = m_sortOrder;
+    auto* watcher = new QFutureWatcher<InitialRows>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        installInitialRows(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&TaskTableModel::readInitialRows, sortColumn, sortOrder));
+}
+
+TaskTableModel::InitialRows TaskTableModel::readInitialRows(int sortColumn, Qt::SortOrder sortOrder)
+{
+    // 本线程的连接只在这次读取中使用，返回时移除
+    ThreadConnectionScope connectionScope;
+
+    InitialRows result;
+    result.sortColumn = sortColumn;
+    result.sortOrder = sortOrder;
+
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "加载任务失败：数据库未打开";
+        return result;
+    }
+
+    result.categories = TaskDatabase::getInstance()->getAllCategories();
+
+    QSqlQuery countQuery("SELECT COUNT(*) FROM tasks", db);
+    if (!countQuery.next()) {
+        qCritical() << "统计任务失败：" << countQuery.lastError().text();
+        return result;
+    }
+    result.totalRows = countQuery.value(0).toInt();
+
+    // 首屏只需要第一页
+    const QString keyExpr = sortKeyExpression(sortColumn);
+    const QString direction = sortOrder == Qt::AscendingOrder ? "ASC" : "DESC";
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT t.id, t.title, t.description, t.category_id, t.priority, t.deadline, t.completed, t.create_time, %1 "
+                            "FROM tasks t ORDER BY %1 %2, t.id %2 LIMIT %3").arg(keyExpr, direction).arg(PageSize))) {
+        qCritical() << "读取任务页失败：" << query.lastError().text();
+        return result;
+    }
+    while (query.next()) {
+        result.rows.append(readRawRow(query));
+    }
+    result.success = true;
+    return result;
+}
+
+void TaskTableModel::installInitialRows(const InitialRows& initial)
+{
+    // 加载期间排序或过滤条件已改变、或读取失败时，退回同步加载
+    if (!initial.success || initial.sortColumn != m_sortColumn || initial.sortOrder != m_sortOrder
+        || !m_filter.isEmpty()) {
+        select();
+        emit firstRowsLoaded();
+        return;
+    }
+
+    beginResetModel();
+    clearPages();
+    setCategories(initial.categories);
+    markCollatedOrdersStale();
+    m_useRowIds = false;
+    m_rowIds.clear();
+    m_totalRows = initial.totalRows;
+    if (!initial.rows.isEmpty()) {
+        storePage(0, initial.rows);
+    }
+    endResetModel();
+
+    emit firstRowsLoaded();
+}
+
+int TaskTableModel::taskId(int row) const
+{
+    int offset = 0;
+    const Columns* columns = columnsForRow(row, &offset);
+    return columns ? columns->ids[offset] : 0;
+}
+
+bool TaskTableModel::isCompleted(int row) const
+{
+    int offset = 0;
+    const Columns* columns = columnsForRow(row, &offset);
+    return columns && columns->completed.testBit(offset);
+}
+
+const TaskTableModel::Columns* TaskTableModel::columnsForRow(int row, int* offset, bool wait) const
+{
+    if (row < 0 || row >= m_totalRows) {
+        return nullptr;
+    }
+
+    const int pageIndex = row / PageSize;
+    const Columns* columns = nullptr;
+    auto it = m_pages.find(pageIndex);
+    if (it != m_pages.end()) {
+        it->lastUsed = ++m_useCounter;
+        columns = &it->columns;
+    } else if (wait) {
+        columns = loadPage(pageIndex);
+    } else {
+        requestPage(pageIndex);
+        return nullptr;
+    }
+
+    *offset = row - pageIndex * PageSize;
+    // 读取期间表被其他连接修改时，页内行数可能少于预期
+    if (!columns || *offset >= columns->size()) {
+        return nullptr;
+    }
+    return columns;
+}
+
+const TaskTableModel::Columns* TaskTableModel::loadPage(int pageIndex) const
+{
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "读取任务页失败：数据库未打开";
+        return nullptr;
+    }
+
+    QVector<RawRow> rawRows;
+    if (!readPageRows(db, pageRequest(pageIndex), &rawRows)) {
+        return nullptr;
+    }
+    return storePage(pageIndex, rawRows);
+}
+
+void TaskTableModel::requestPage(int pageIndex) const
+{
+    if (m_loadingPages.contains(pageIndex)) {
+        return;
+    }
+    m_loadingPages.insert(pageIndex);
+
+    // data() 是 const：发起读取只改动页缓存状态，装入时再通知视图
+    auto* self = const_cast<TaskTableModel*>(this);
+    auto* watcher = new QFutureWatcher<PageRows>(self);
+    connect(watcher, &QFutureWatcherBase::finished, self, [self, watcher]() {
+        self->installPage(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&TaskTableModel::readPage, pageRequest(pageIndex)));
+}
+
+void TaskTableModel::installPage(const PageRows& page)
+{
+    // 缓存已清空（排序、过滤或刷新）后才返回的页直接丢弃
+    if (page.generation != m_pageGeneration) {
+        return;
+    }
+    m_loadingPages.remove(page.pageIndex);
+    // 等待期间可能已被同步读取（taskId() 等）
+    if (!page.success || m_pages.contains(page.pageIndex)) {
+        return;
+    }
+
+    storePage(page.pageIndex, page.rows);
+    const int firstRow = page.pageIndex * PageSize;
+    const int lastRow = qMin(firstRow + PageSize, m_totalRows) - 1;
+    if (lastRow >= firstRow) {
+        emit dataChanged(index(firstRow, 0), index(lastRow, ColumnCount - 1));
+    }
+}
+
+const TaskTableModel::Columns* TaskTableModel::storePage(int pageIndex, const QVector<RawRow>& rawRows) const
+{
+    evictPages();
+
+    Page& page = m_pages[pageIndex];
+    page.lastUsed = ++m_useCounter;
+    Columns& columns = page.columns;
+    columns.reserve(rawRows.size());
+
+    QHash<QString, int> titleIndex; // 页内标题去重
+    for (int row = 0; row < rawRows.size(); ++row) {
+        const RawRow& raw = rawRows[row];
+        columns.ids.append(raw.id);
+        auto titleIt = titleIndex.constFind(raw.title);
+        if (titleIt == titleIndex.constEnd()) {
+            titleIt = titleIndex.insert(raw.title, columns.strings.size());
+            columns.strings.append(raw.title);
+        }
+        columns.titles.append(titleIt.value());
+        columns.descriptions.append(raw.description);
+        columns.categorySlots.append(categorySlot(raw.categoryId));
+        columns.priorities.append(quint8(raw.priority));
+        columns.deadlines.append(toMSecs(raw.deadline));
+        columns.completed.setBit(row, raw.completed);
+        columns.createTimes.append(toMSecs(raw.createTime));
+    }
+    columns.deadlineTexts.resize(rawRows.size());
+    columns.createTimeTexts.resize(rawRows.size());
+
+    // 记录本页首尾排序键，供相邻页键集续读
+    if (!rawRows.isEmpty() && !m_useRowIds) {
+        page.firstKey = { rawRows.first().key, rawRows.first().id };
+        page.lastKey = { rawRows.last().key, rawRows.last().id };
+    }
+    return &columns;
+}
+
+TaskTableModel::PageRequest TaskTableModel::pageRequest(int pageIndex) const
+{
+    PageRequest request;
+    request.generation = m_pageGeneration;
+    request.pageIndex = pageIndex;
+    request.sortColumn = m_sortColumn;
+    request.sortOrder = m_sortOrder;
+    request.useRowIds = m_useRowIds;
+
+    const int firstRow = pageIndex * PageSize;
+    request.expectedRows = qMin(PageSize, m_totalRows - firstRow);
+    if (m_useRowIds) {
+        request.ids = m_rowIds.mid(firstRow, request.expectedRows);
+        return request;
+    }
+
+    // 选择读取方式：优先从常驻的相邻页锚点续读（键集），其次倒序读取表尾
+    // （跳到表尾只读最后一页），都不满足时才退回 OFFSET
+    if (pageIndex > 0) {
+        auto before = m_pages.constFind(pageIndex - 1);
+        auto after = m_pages.constFind(pageIndex + 1);
+        if (before != m_pages.constEnd() && before->lastKey.id) {
+            request.anchor = before->lastKey;
+        } else if (after != m_pages.constEnd() && after->firstKey.id) {
+            request.anchor = after->firstKey;
+            request.forward = false;
+        } else if (firstRow + request.expectedRows >= m_totalRows) {
+            request.forward = false;
+        } else {
+            request.offset = firstRow;
+        }
+    }
+    return request;
+}
+
+TaskTableModel::PageRows TaskTableModel::readPage(const PageRequest& request)
+{
+    // 本线程的连接只在这次读取中使用，返回时移除
+    ThreadConnectionScope connectionScope;
+
+    PageRows result;
+    result.generation = request.generation;
+    result.pageIndex = request.pageIndex;
+
+    QSqlDatabase db = TaskDatabase::getInstance()->getDatabaseConnection();
+    if (!db.isOpen()) {
+        qWarning() << "读取任务页失败：数据库未打开";
+        return result;
+    }
+    result.success = readPageRows(db, request, &result.rows);
+    return result;
+}
+
+bool TaskTableModel::readPageRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows)
+{
+    // 先收集原始行，再按显示顺序写入列数组
+    rawRows->reserve(request.expectedRows);
+    return request.useRowIds ? readIdRows(db, request, rawRows) : readKeysetRows(db, request, rawRows);
+}
+
+bool TaskTableModel::readKeysetRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows)
+{
+    const bool ascending = request.sortOrder == Qt::AscendingOrder;
+    const bool forward = request.forward;
+    const SortKey* anchor = request.anchor.id ? &request.anchor : nullptr;
+    const QString keyExpr = sortKeyExpression(request.sortColumn);
+
+    const bool scanAscending = (forward == ascending);
+    const QString direction = scanAscending ? "ASC" : "DESC";
+    QString sql = QString("SELECT t.id, t.title, t.description, t.category_id, t.priority, t.deadline, t.completed, t.create_time, %1 "
+                          "FROM tasks t").arg(keyExpr);
+    if (anchor) {
+        sql += QString(" WHERE (%1, t.id) %2 (:key, :id)").arg(keyExpr, scanAscending ? ">" : "<");
+    }
+    sql += QString(" ORDER BY %1 %2, t.id %2 LIMIT %3").arg(keyExpr, direction).arg(request.expectedRows);
+    if (request.offset > 0) {
+        sql += QString(" OFFSET %1").arg(request.offset);
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    if (anchor) {
+        query.bindValue(":key", anchor->value);
+        query.bindValue(":id", anchor->id);
+    }
+    if (!query.exec()) {
+        qCritical() << "读取任务页失败：" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        rawRows->append(readRawRow(query));
+    }
+    // 倒序读取的页翻转回显示顺序
+    if (!forward) {
+        std::reverse(rawRows->begin(), rawRows->end());
+    }
+    return true;
+}
+
+bool TaskTableModel::readIdRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows)
+{
+    // 按本页的任务 id 一次性读取这些行
+    const int expectedRows = request.ids.size();
+    QHash<int, int> positions;
+    QStringList idList;
+    positions.reserve(expectedRows);
+    for (int row = 0; row < expectedRows; ++row) {
+        const int id = request.ids[row];
+        positions.insert(id, row);
+        idList.append(QString::number(id));
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    QString sql = "SELECT id, title, description, category_id, priority, deadline, completed, create_time, NULL "
+                  "FROM tasks WHERE id IN (" + idList.join(',') + ")";
+    if (!query.exec(sql)) {
+        qCritical() << "读取任务页失败：" << query.lastError().text();
+        return false;
+    }
+
+    QVector<RawRow> ordered(expectedRows);
+    QBitArray found(expectedRows);
+    while (query.next()) {
+        RawRow raw = readRawRow(query);
+        const int position = positions.value(raw.id, -1);
+        if (position >= 0) {
+            ordered[position] = std::move(raw);
+            found.setBit(position);
+        }
+    }
+    // 列表建立后被删除的任务直接跳过
+    for (int i = 0; i < expectedRows; ++i) {
+        if (found.testBit(i)) {
+            rawRows->append(std::move(ordered[i]));
+        }
+    }
+    return true;
+}
+
+TaskTableModel::RawRow TaskTableModel::readRawRow(const QSqlQuery& query)
+{
+    RawRow raw;
+    raw.id = query.value(0).toInt();
+    raw.title = query.value(1).toString();
+    raw.description = query.value(2).toString();
+    raw.categoryId = query.value(3).toInt();
+    raw.priority = query.value(4).toInt();
+    raw.deadline = query.value(5);
+    raw.completed = query.value(6).toBool();
+    raw.createTime = query.value(7);
+    raw.key = query.value(8);
+    return raw;
+}
+
+void TaskTableModel::evictPages() const
+{
+    // 超出常驻上限时淘汰最久未使用的页（连同其锚点），内存占用有上界
+    while (m_pages.size() >= MaxResidentPages) {
+        auto oldest = m_pages.begin();
+        for (auto it = m_pages.begin(); it != m_pages.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) {
+                oldest = it;
+            }
+        }
+        m_pages.erase(oldest);
+    }
+}
+
+void TaskTableModel::clearPages()
+{
+    m_pages.clear();
+    m_loadingPages.clear();
+    ++m_pageGeneration;
+}
+
+QString TaskTableModel::sortKeyExpression(int column)
+{
+    // 可为空的列统一转成 ''，保证键集比较（行值比较）对 NULL 也成立；
+    // 每个表达式在 TaskDatabase::init 中都有对应的 (表达式, id) 索引，修改时须同步；
+    // 标题、分类列平时按排序键排列（见 buildCollatedOrder），这里只用于排列生成前或生成失败时
+    switch (column) {
+    case IdColumn: return "t.id";
+    case TitleColumn: return "IFNULL(t.title, '')";
+    case CategoryColumn: return "IFNULL(t.category_id, 0)";
+    case DescriptionColumn: return "IFNULL(t.description, '')";
+    case PriorityColumn: return "t.priority";
+    case CompletedColumn: return "t.completed";
+    case CreateTimeColumn: return "t.create_time";
+    case DeadlineColumn:
+    default: return "IFNULL(t.deadline, '')";
+    }
+}
+
+void TaskTableModel::setCategories(const QList<Category>& categories)
+{
+    // 分类表很小，整体载入并分配槽位
+    m_categoryIds = { 0 };
+    m_categoryNames = { tr("未分类") };
+    m_categorySlotById.clear();
+    for (const Category& cat : categories) {
+        m_categorySlotById.insert(cat.id, quint16(m_categoryIds.size()));
+        m_categoryIds.append(cat.id);
+        m_categoryNames.append(cat.name);
+    }
+}
+
+void TaskTableModel::markCollatedOrdersStale()
+{
+    // 已缓存的排列在下次使用时增量重排
+    ++m_dataVersion;
+    for (auto it = m_collatedOrders.begin(); it != m_collatedOrders.end(); ++it) {
+        it->stale = true;
+    }
+}
+
+bool TaskTableModel::isCollatedSort() const
+{
+    return m_sortColumn == TitleColumn || m_sortColumn == CategoryColumn;
+}
+
+bool TaskTableModel::buildCollatedOrder(QSqlDatabase& db, const RowOrderRequest& request,
+                                        CollatedOrder* order, const CancelToken& token)
+{
+    // 只读取 id 和排序列
+    const bool byTitle = request.sortColumn == TitleColumn;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(byTitle ? "SELECT id, title FROM tasks" : "SELECT id, category_id FROM tasks")) {
+        if (!token->load()) {
+            qCritical() << "排序失败：" << query.lastError().text();
+        }
+        return false;
+    }
+
+    // 文本未变化的行沿用缓存的排序键，新增或修改过的行才重新生成
+    QCollator collator(QLocale(QLocale::Chinese, QLocale::China));
+    const SortKeyCache noKeys;
+    const SortKeyCache& cache = request.collatedOrder.keys ? *request.collatedOrder.keys : noKeys;
+    auto keys = std::make_shared<SortKeyCache>();
+    keys->reserve(cache.size());
+    std::unordered_map<int, QCollatorSortKey> categoryKeys; // 分类很少，每个分类只生成一次
+    QVector<int> fresh;
+    while (query.next()) {
+        if (token->load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const int id = query.value(0).toInt();
+        const int categoryId = byTitle ? 0 : query.value(1).toInt();
+        const QString text = byTitle ? query.value(1).toString()
+                                     : request.categoryNames.value(categoryId, request.uncategorizedName);
+        const size_t textHash = qHash(text);
+
+        auto cached = cache.find(id);
+        if (cached != cache.end() && cached->second.textHash == textHash) {
+            keys->emplace(id, cached->second);
+            continue;
+        }
+
+        if (byTitle) {
+            keys->emplace(id, CachedSortKey{ textHash, collator.sortKey(text) });
+        } else {
+            auto categoryKey = categoryKeys.find(categoryId);
+            if (categoryKey == categoryKeys.end()) {
+                categoryKey = categoryKeys.emplace(categoryId, collator.sortKey(text)).first;
+            }
+            keys->emplace(id, CachedSortKey{ textHash, categoryKey->second });
+        }
+        fresh.append(id);
+    }
+    // 被中断的语句 next() 提前返回 false
+    if (token->load()) {
+        return false;
+    }
+
+    using Entry = std::pair<const QCollatorSortKey*, int>;
+    auto less = [](const Entry& a, const Entry& b) {
+        const int cmp = a.first->compare(*b.first);
+        return cmp < 0 || (cmp == 0 && a.second < b.second);
+    };
+
+    // 旧排列中键未变化的行相对顺序不变，只需把变化的行排序后归并：O(n + k log k)
+    const QSet<int> freshIds(fresh.begin(), fresh.end());
+    std::vector<Entry> kept;
+    kept.reserve(keys->size());
+    for (int id : std::as_const(request.collatedOrder.ids)) {
+        auto it = keys->find(id);
+        if (it != keys->end() && !freshIds.contains(id)) {
+            kept.push_back({ &it->second.key, id });
+        }
+    }
+    std::vector<Entry> added;
+    if (kept.size() + size_t(fresh.size()) == keys->size()) {
+        added.reserve(fresh.size());
+        for (int id : std::as_const(fresh)) {
+            added.push_back({ &keys->at(id).key, id });
+        }
+    } else {
+        // 缓存与旧排列不一致时整体重排
+        kept.clear();
+        added.reserve(keys->size());
+        for (auto& entry : *keys) {
+            added.push_back({ &entry.second.key, entry.first });
+        }
+    }
+    std::sort(added.begin(), added.end(), less);
+
+    std::vector<Entry> merged(kept.size() + added.size());
+    std::merge(kept.begin(), kept.end(), added.begin(), added.end(), merged.begin(), less);
+
+    order->ids.resize(int(merged.size()));
+    for (size_t i = 0; i < merged.size(); ++i) {
+        order->ids[int(i)] = merged[i].second;
+    }
+    // 换入本次的键，已删除任务的键随旧快照一起释放
+    order->keys = std::move(keys);
+    order->stale = false;
+    return true;
+}
+
+quint16 TaskTableModel::categorySlot(int categoryId) const
+{
+    return m_categorySlotById.value(categoryId, 0);
+}
+
+QString TaskTableModel::formatDateTime(qint64 msecs)
+{
+    if (msecs < 0) {
+        return QString("");
+    }
+    return QDateTime::fromMSecsSinceEpoch(msecs).toString("yyyy-MM-dd HH:mm");
+}
+
+qint64 TaskTableModel::toMSecs(const QVariant& value)
+{
+    QDateTime dateTime = value.toDateTime();
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : -1;
+}
@@ -0,0 +1,301 @@
+#ifndef TASKTABLEMODEL_H
+#define TASKTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QBitArray>
+#include <QCollator>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include "TaskDatabase.h"
+
+// 组合过滤条件：全部基于原始字段并在数据库中求值，取值为 -1（或空文本）的条件不参与过滤
+struct TaskFilter {
+    int categoryId = -1;       // 分类 id，0 表示未分类
+    int priority = -1;         // TaskPriority
+    int completed = -1;        // 0 未完成，1 已完成
+    qint64 deadlineFrom = -1;  // 毫秒时间戳（含）
+    qint64 deadlineTo = -1;    // 毫秒时间戳（含）
+    QString text;              // 标题、描述、分类、优先级或完成状态包含（不区分大小写）
+    // 后台搜索得到的 text 命中 id（升序）；非空时代替 SQL 文本匹配
+    std::shared_ptr<const QVector<int>> matchingIds;
+
+    bool isEmpty() const;
+    // 通过本条件的行一定通过 other（条件只增不减、范围只缩不扩、文本只在原文本上追加）
+    bool narrows(const TaskFilter& other) const;
+    // 对应的 SQL 条件（不含 WHERE，表别名 t），参数按出现顺序追加到 values；无条件时返回空串
+    QString sqlCondition(QVariantList* values) const;
+    bool operator==(const TaskFilter& other) const;
+    bool operator!=(const TaskFilter& other) const { return !(*this == other); }
+};
+
+// 列式任务表模型：行按页（键集分页）按需从数据库读取，
+// 页内每个字段一个连续数组，data() 只做数组下标访问。
+// data() 遇到未载入的页时在后台读取并先返回占位内容，读完后通过 dataChanged 刷新。
+// 有过滤条件时在后台按条件和排序查询出 id 列表，按该列表分页读取。
+// 标题、分类列按中文排序规则（拼音）排序，排序键按行预先生成并缓存。
+class TaskTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    // 列定义（与 tasks 表字段顺序一致）
+    enum Column {
+        IdColumn = 0,
+        TitleColumn,
+        DescriptionColumn,
+        CategoryColumn,
+        PriorityColumn,
+        DeadlineColumn,
+        CompletedColumn,
+        CreateTimeColumn,
+        ColumnCount
+    };
+
+    // 原始字段角色：供过滤、编辑等逻辑直接读取，无需解析显示文本
+    enum TaskRole {
+        TaskIdRole = Qt::UserRole + 1,
+        CategoryIdRole,
+        PriorityRole,
+        CompletedRole,
+        DeadlineRole,
+        CreateTimeRole
+    };
+
+    // 每页行数与常驻内存的最大页数（超出后按最久未使用淘汰）
+    static constexpr int PageSize = 256;
+    static constexpr int MaxResidentPages = 64;
+
+    explicit TaskTableModel(QObject *parent = nullptr);
+    ~TaskTableModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // 排序：一般列交给数据库；标题、分类列使用预生成排序键得到的排列。
+    // 清空已缓存的页，之后按新顺序按需读取
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // 重新统计行数并丢弃所有缓存页（不读取任何任务行）；有过滤条件时在后台重新查询
+    bool select();
+
+    // 过滤：条件在数据库中求值，结果 id 列表在后台查询完成后一次性换入
+    const TaskFilter& filter() const { return m_filter; }
+    void setFilter(const TaskFilter& filter);
+
+    // 启动用：在后台统计行数并读取首屏所在的第一页，完成后一次性装入
+    void selectAsync();
+
+    // 原始字段访问
+    int taskId(int row) const;
+    bool isCompleted(int row) const;
+
+    // 当前常驻内存的页数
+    int residentPageCount() const { return m_pages.size(); }
+
+signals:
+    // selectAsync() 完成（首屏数据可显示）
+    void firstRowsLoaded();
+
+private:
+    // 列式存储：同一字段的所有行放在一个数组里
+    struct Columns {
+        QVector<int> ids;
+        QVector<int> titles;             // strings 中的下标（页内标题去重）
+        QVector<QString> strings;
+        QVector<QString> descriptions;
+        QVector<quint16> categorySlots;  // m_categoryIds/m_categoryNames 中的下标
+        QVector<quint8> priorities;
+        QVector<qint64> deadlines;       // 毫秒时间戳，无截止时间为 -1
+        QVector<qint64> createTimes;
+        QBitArray completed;
+
+        // 显示文本缓存：首次绘制时格式化一次，之后直接返回
+        mutable QVector<QString> deadlineTexts;
+        mutable QVector<QString> createTimeTexts;
+
+        int size() const { return ids.size(); }
+        void reserve(int rows);
+    };
+
+    // 键集分页的锚点：排序键 + id（id 保证顺序唯一）
+    struct SortKey {
+        QVariant value;
+        int id = 0;
+    };
+
+    // 页首尾的锚点随页一起淘汰，供相邻页键集续读
+    struct Page {
+        Columns columns;
+        SortKey firstKey;
+        SortKey lastKey;
+        quint64 lastUsed = 0;
+    };
+
+    // 数据库读出的一行（写入列数组前的中间形式）
+    struct RawRow {
+        int id = 0;
+        QString title;
+        QString description;
+        int categoryId = 0;
+        int priority = 0;
+        QVariant deadline;
+        bool completed = false;
+        QVariant createTime;
+        QVariant key;
+    };
+
+    // 读取一页所需的全部输入，在界面线程生成，可在工作线程执行
+    struct PageRequest {
+        quint64 generation = 0;
+        int pageIndex = 0;
+        int expectedRows = 0;
+        int sortColumn = DeadlineColumn;
+        Qt::SortOrder sortOrder = Qt::AscendingOrder;
+        // id 列表分页：本页的任务 id
+        bool useRowIds = false;
+        QVector<int> ids;
+        // 键集分页：相邻页的锚点（anchor.id 为 0 表示没有），没有锚点时倒序读表尾或退回 OFFSET
+        SortKey anchor;
+        bool forward = true;
+        int offset = 0;
+    };
+
+    struct PageRows {
+        quint64 generation = 0;
+        int pageIndex = 0;
+        bool success = false;
+        QVector<RawRow> rows;
+    };
+
+    // 后台读取的启动数据
+    struct InitialRows {
+        bool success = false;
+        int sortColumn = DeadlineColumn;
+        Qt::SortOrder sortOrder = Qt::AscendingOrder;
+        int totalRows = 0;
+        QList<Category> categories;
+        QVector<RawRow> rows;
+    };
+
+    // 按行缓存的排序键：文本未变化（按哈希判断）时直接复用
+    struct CachedSortKey {
+        size_t textHash;
+        QCollatorSortKey key;
+    };
+    using SortKeyCache = std::unordered_map<int, CachedSortKey>;
+
+    // 某一列按排序键升序排列的任务 id；降序时反向读取。
+    // 排序键只在后台生成，界面线程只持有不可变的快照
+    struct CollatedOrder {
+        QVector<int> ids;
+        std::shared_ptr<const SortKeyCache> keys;
+        bool stale = false; // 数据已刷新，需按变化的行重排
+    };
+
+    using CancelToken = std::shared_ptr<std::atomic_bool>;
+
+    // 后台行序查询的输入与结果
+    struct RowOrderRequest {
+        quint64 generation = 0;
+        TaskFilter filter;
+        int sortColumn = DeadlineColumn;
+        Qt::SortOrder sortOrder = Qt::AscendingOrder;
+        bool collated = false;
+        // 条件只是收紧：在上次结果中筛选并保持其顺序，不再排序
+        bool narrowing = false;
+        QVector<int> candidates;
+        // 标题、分类排序：上次的完整排列与排序键，过期或缺失时在后台增量重排
+        CollatedOrder collatedOrder;
+        bool rebuildOrder = false;
+        quint64 dataVersion = 0;
+        QHash<int, QString> categoryNames;
+        QString uncategorizedName;
+    };
+
+    struct RowOrder {
+        quint64 generation = 0;
+        bool success = false;
+        bool cancelled = false;
+        QVector<int> ids; // 通过过滤的任务 id，按显示顺序
+        // 重排得到的完整排列，数据未再刷新时装入缓存
+        int sortColumn = DeadlineColumn;
+        quint64 dataVersion = 0;
+        bool orderRebuilt = false;
+        CollatedOrder collatedOrder;
+    };
+
+    // wait 为 false 时页未载入就发起后台读取并返回 nullptr
+    const Columns* columnsForRow(int row, int* offset, bool wait = true) const;
+    const Columns* loadPage(int pageIndex) const;
+    void requestPage(int pageIndex) const;
+    void installPage(const PageRows& page);
+    const Columns* storePage(int pageIndex, const QVector<RawRow>& rawRows) const;
+    PageRequest pageRequest(int pageIndex) const;
+    static PageRows readPage(const PageRequest& request);
+    static bool readPageRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows);
+    static bool readKeysetRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows);
+    static bool readIdRows(QSqlDatabase& db, const PageRequest& request, QVector<RawRow>* rawRows);
+    static RawRow readRawRow(const QSqlQuery& query);
+    void evictPages() const;
+    void clearPages();
+    static QString sortKeyExpression(int column);
+
+    static InitialRows readInitialRows(int sortColumn, Qt::SortOrder sortOrder);
+    void installInitialRows(const InitialRows& initial);
+    void setCategories(const QList<Category>& categories);
+    void markCollatedOrdersStale();
+
+    bool loadUnfilteredRows(bool recount);
+    void startRowOrderQuery(bool narrowCurrentRows = false);
+    bool narrowRowIdsInPlace(const TaskFilter& previous);
+    void cancelRowOrderQuery();
+    static RowOrder readRowOrder(const RowOrderRequest& request, CancelToken token);
+    void installRowOrder(const RowOrder& order);
+
+    bool isCollatedSort() const;
+    static bool buildCollatedOrder(QSqlDatabase& db, const RowOrderRequest& request,
+                                   CollatedOrder* order, const CancelToken& token);
+
+    quint16 categorySlot(int categoryId) const;
+    static QString formatDateTime(qint64 msecs);
+    static qint64 toMSecs(const QVariant& value);
+
+    int m_totalRows = 0;
+    int m_sortColumn = DeadlineColumn;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+
+    mutable QHash<int, Page> m_pages;
+    mutable quint64 m_useCounter = 0;
+    // 正在后台读取的页；清空缓存时代数加一，之前发起的读取结果不再装入
+    mutable QSet<int> m_loadingPages;
+    quint64 m_pageGeneration = 0;
+
+    // 过滤或标题、分类排序时按 id 列表分页，否则按键集分页
+    TaskFilter m_filter;
+    bool m_useRowIds = false;
+    QVector<int> m_rowIds; // 按显示顺序排列的任务 id
+    bool m_rowIdsMatchFilter = false; // m_rowIds 是 m_filter 在当前排序下的完整结果
+    quint64 m_rowOrderGeneration = 0;
+    CancelToken m_rowOrderToken;
+
+    // 标题、分类排序：按列缓存的排列（含按任务缓存的排序键）
+    QHash<int, CollatedOrder> m_collatedOrders;
+    quint64 m_dataVersion = 0; // 每次刷新数据加一，过期的重排结果不再装入
+
+    // 分类：槽位 0 固定为“未分类”
+    QVector<int> m_categoryIds;
+    QVector<QString> m_categoryNames;
+    QHash<int, quint16> m_categorySlotById;
+
+    // 固定文本（优先级、完成状态）只构造一次
+    QVector<QString> m_priorityTexts;
+    QString m_completedText;
+    QString m_pendingText;
+};
+
+#endif // TASKTABLEMODEL_H
@@ -0,0 +1,250 @@
+#include "XlsxStreamWriter.h"
+#include "xlsxsheetdatawriter_p.h"
+#include "xlsxutility_p.h"
+#include "xlsxzipwriter_p.h"
+
+XlsxStreamWriter::XlsxStreamWriter(const QString& filePath)
+    : m_file(filePath)
+{
+}
+
+XlsxStreamWriter::~XlsxStreamWriter() = default;
+
+bool XlsxStreamWriter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail("无法打开文件：" + m_file.errorString());
+    }
+    m_created = true;
+
+    m_zip.reset(new QXlsx::ZipWriter(&m_file));
+    m_zip->setCompressionLevel(m_compressionLevel);
+    return true;
+}
+
+bool XlsxStreamWriter::close()
+{
+    if (!m_zip) {
+        return false;
+    }
+    if (m_sheet) {
+        endSheet();
+    }
+
+    // 工作簿结构、样式等小部件在所有工作表写完后一次写入
+    writeEntry("[Content_Types].xml", contentTypesXml());
+    writeEntry("_rels/.rels", rootRelsXml());
+    writeEntry("xl/workbook.xml", workbookXml());
+    writeEntry("xl/_rels/workbook.xml.rels", workbookRelsXml());
+    writeEntry("xl/styles.xml", stylesXml());
+
+    m_zip->close();
+    if (m_zip->error()) {
+        fail("写入文件失败：" + m_file.errorString());
+    }
+    m_zip.reset();
+    m_file.close();
+    return !m_failed;
+}
+
+void XlsxStreamWriter::abort()
+{
+    // 先结束 ZipWriter（它在文件关闭前写完剩余数据），再删除文件
+    m_sheet.reset();
+    m_zip.reset();
+    m_file.close();
+    // 打开失败时文件不是本写入器创建的（可能是已有文件），不能删除
+    if (m_created) {
+        m_file.remove();
+    }
+    fail("导出已取消");
+}
+
+bool XlsxStreamWriter::beginSheet(const QString& name)
+{
+    if (m_sheet && !endSheet()) {
+        return false;
+    }
+    if (m_failed || !m_zip) {
+        return false;
+    }
+
+    m_sheetNames.append(name);
+    QIODevice* device = m_zip->openFile(QString("xl/worksheets/sheet%1.xml").arg(m_sheetNames.size()));
+    if (!device) {
+        return fail("写入文件失败：" + m_file.errorString());
+    }
+
+    // 单元格引用、转义和数字格式与 QXlsx 保存工作表时共用同一个写入器
+    m_sheet.reset(new QXlsx::SheetDataWriter(device));
+    m_row = 0;
+    m_sheet->writeLiteral("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                          "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>");
+    return true;
+}
+
+bool XlsxStreamWriter::endSheet()
+{
+    if (!m_sheet) {
+        return false;
+    }
+    m_sheet->writeLiteral("</sheetData></worksheet>");
+    m_sheet->flush();
+    const bool written = !m_sheet->hasError();
+    m_sheet.reset();
+    m_zip->closeFile();
+    if (!written || m_zip->error()) {
+        return fail("写入文件失败：" + m_file.errorString());
+    }
+    return true;
+}
+
+void XlsxStreamWriter::beginRow()
+{
+    ++m_row;
+    m_column = 0;
+    m_sheet->writeLiteral("<row r=\"");
+    m_sheet->writeInt(m_row);
+    m_sheet->writeLiteral("\">");
+}
+
+void XlsxStreamWriter::addNumber(double value)
+{
+    ++m_column;
+    m_sheet->writeLiteral("<c r=\"");
+    m_sheet->writeCellReference(m_row, m_column);
+    m_sheet->writeLiteral("\"><v>");
+    m_sheet->writeDouble(value);
+    m_sheet->writeLiteral("</v></c>");
+}
+
+void XlsxStreamWriter::addString(const QString& value)
+{
+    ++m_column;
+    if (value.isEmpty()) {
+        return;
+    }
+    m_sheet->writeLiteral("<c r=\"");
+    m_sheet->writeCellReference(m_row, m_column);
+    m_sheet->writeLiteral("\" t=\"inlineStr\"><is><t");
+    if (QXlsx::isSpaceReserveNeeded(value)) {
+        m_sheet->writeLiteral(" xml:space=\"preserve\"");
+    }
+    m_sheet->writeLiteral(">");
+    m_sheet->writeEscaped(value);
+    m_sheet->writeLiteral("</t></is></c>");
+}
+
+void XlsxStreamWriter::addDateTime(const QDateTime& value)
+{
+    if (!value.isValid()) {
+        addEmpty();
+        return;
+    }
+    ++m_column;
+    // 样式 1：yyyy-mm-dd hh:mm；序列值与 QXlsx::Worksheet::writeDateTime 一致
+    m_sheet->writeLiteral("<c r=\"");
+    m_sheet->writeCellReference(m_row, m_column);
+    m_sheet->writeLiteral("\" s=\"1\"><v>");
+    m_sheet->writeDouble(QXlsx::datetimeToNumber(value));
+    m_sheet->writeLiteral("</v></c>");
+}
+
+void XlsxStreamWriter::addEmpty()
+{
+    ++m_column;
+}
+
+void XlsxStreamWriter::endRow()
+{
+    m_sheet->writeLiteral("</row>");
+}
+
+bool XlsxStreamWriter::writeEntry(const QString& name, const QByteArray& data)
+{
+    if (m_failed) {
+        return false;
+    }
+    m_zip->addFile(name, data);
+    if (m_zip->error()) {
+        return fail("写入文件失败：" + m_file.errorString());
+    }
+    return true;
+}
+
+bool XlsxStreamWriter::fail(const QString& message)
+{
+    if (!m_failed) {
+        m_failed = true;
+        m_errorString = message;
+    }
+    return false;
+}
+
+QByteArray XlsxStreamWriter::workbookXml() const
+{
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                     "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+                     "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\"><sheets>";
+    for (int i = 0; i < m_sheetNames.size(); ++i) {
+        xml += "<sheet name=\"" + m_sheetNames[i].toHtmlEscaped().toUtf8() + "\" sheetId=\""
+               + QByteArray::number(i + 1) + "\" r:id=\"rId" + QByteArray::number(i + 1) + "\"/>";
+    }
+    xml += "</sheets></workbook>";
+    return xml;
+}
+
+QByteArray XlsxStreamWriter::workbookRelsXml() const
+{
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                     "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    for (int i = 0; i < m_sheetNames.size(); ++i) {
+        xml += "<Relationship Id=\"rId" + QByteArray::number(i + 1)
+               + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" "
+                 "Target=\"worksheets/sheet" + QByteArray::number(i + 1) + ".xml\"/>";
+    }
+    xml += "<Relationship Id=\"rId" + QByteArray::number(m_sheetNames.size() + 1)
+           + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>";
+    xml += "</Relationships>";
+    return xml;
+}
+
+QByteArray XlsxStreamWriter::contentTypesXml() const
+{
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                     "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                     "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                     "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                     "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+                     "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>";
+    for (int i = 0; i < m_sheetNames.size(); ++i) {
+        xml += "<Override PartName=\"/xl/worksheets/sheet" + QByteArray::number(i + 1)
+               + ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+    }
+    xml += "</Types>";
+    return xml;
+}
+
+QByteArray XlsxStreamWriter::rootRelsXml()
+{
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+           "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+           "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+           "</Relationships>";
+}
+
+QByteArray XlsxStreamWriter::stylesXml()
+{
+    // 样式 0 为默认，样式 1 为日期时间
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+           "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+           "<numFmts count=\"1\"><numFmt numFmtId=\"164\" formatCode=\"yyyy-mm-dd hh:mm\"/></numFmts>"
+           "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+           "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill><fill><patternFill patternType=\"gray125\"/></fill></fills>"
+           "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+           "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+           "<cellXfs count=\"2\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+           "<xf numFmtId=\"164\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/></cellXfs>"
+           "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+           "</styleSheet>";
+}
@@ -0,0 +1,72 @@
+#ifndef XLSXSTREAMWRITER_H
+#define XLSXSTREAMWRITER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+namespace QXlsx {
+class SheetDataWriter;
+class ZipWriter;
+}
+
+// 流式 XLSX 写入器：工作表 XML 边生成边通过 QXlsx::ZipWriter 的流式条目压缩写入，内存占用与行数无关；
+// 超过 4 GiB 的条目或文件自动使用 ZIP64。
+// 字符串以内联字符串写入，不需要在内存中维护共享字符串表。
+// 用法：open() → beginSheet() → beginRow() / add*() / endRow() … → endSheet() → close()
+class XlsxStreamWriter
+{
+public:
+    explicit XlsxStreamWriter(const QString& filePath);
+    ~XlsxStreamWriter();
+
+    // zlib 压缩级别 0~9，-1 为默认（6），须在 open() 之前设置
+    void setCompressionLevel(int level) { m_compressionLevel = level; }
+
+    bool open();
+    bool close();
+    // 放弃导出：结束压缩流并删除 open() 创建的未完成文件
+    void abort();
+
+    bool beginSheet(const QString& name);
+    bool endSheet();
+
+    void beginRow();
+    void addNumber(double value);
+    void addString(const QString& value);
+    void addDateTime(const QDateTime& value);
+    void addEmpty();
+    void endRow();
+
+    QString errorString() const { return m_errorString; }
+    qint64 bytesWritten() const { return m_file.isOpen() ? m_file.pos() : m_file.size(); }
+
+private:
+    bool writeEntry(const QString& name, const QByteArray& data);
+
+    bool fail(const QString& message);
+
+    QByteArray workbookXml() const;
+    QByteArray workbookRelsXml() const;
+    QByteArray contentTypesXml() const;
+    static QByteArray rootRelsXml();
+    static QByteArray stylesXml();
+
+    QFile m_file;
+    QString m_errorString;
+    bool m_failed = false;
+    bool m_created = false; // open() 成功创建了文件
+
+    std::unique_ptr<QXlsx::ZipWriter> m_zip;
+    std::unique_ptr<QXlsx::SheetDataWriter> m_sheet; // 写入当前工作表的流式条目
+    int m_compressionLevel = -1;
+
+    QStringList m_sheetNames;
+    int m_row = 0;
+    int m_column = 0;
+};
+
+#endif // XLSXSTREAMWRITER_H
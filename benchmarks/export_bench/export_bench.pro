@@ -0,0 +1,32 @@
+# 导出性能基准：生成指定规模的合成数据库，测量各导出方式的耗时、吞吐、峰值内存与输出大小
+# 用法：qmake && make && ./export_bench --rows 1000000 --json results.json
+QT += core gui widgets sql concurrent printsupport
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TARGET = export_bench
+TEMPLATE = app
+
+APP_ROOT = $$PWD/../..
+INCLUDEPATH += $$APP_ROOT
+
+# XlsxStreamWriter 通过 QXlsx::ZipWriter 写入 zip（zlib 由 QXlsx.pri 链接）
+QXLSX_ROOT = $$APP_ROOT/QXlsx
+include($$QXLSX_ROOT/QXlsx.pri)
+
+# TaskDatabase 的查询取消使用 SQLite 进度回调（与主程序相同）
+LIBS += -lsqlite3
+
+SOURCES += \
+    main.cpp \
+    $$APP_ROOT/ExportManager.cpp \
+    $$APP_ROOT/ExportSinks.cpp \
+    $$APP_ROOT/PdfReportRenderer.cpp \
+    $$APP_ROOT/TaskDatabase.cpp \
+    $$APP_ROOT/XlsxStreamWriter.cpp
+
+HEADERS += \
+    $$APP_ROOT/ExportManager.h \
+    $$APP_ROOT/ExportSinks.h \
+    $$APP_ROOT/PdfReportRenderer.h \
+    $$APP_ROOT/TaskDatabase.h \
+    $$APP_ROOT/XlsxStreamWriter.h
@@ -0,0 +1,350 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+#include "ExportManager.h"
+#include "ExportSinks.h"
+#include "TaskDatabase.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// 合成数据库参数
+struct GeneratorConfig {
+    int rows = 100000;
+    int categories = 8;
+    QVector<int> priorityWeights = {5, 3, 2}; // 低/中/高
+    int descriptionMin = 0;
+    int descriptionMax = 200;
+    double completedRatio = 0.3;
+    double uncategorizedRatio = 0.05;
+    quint32 seed = 1;
+};
+
+// 单项测量结果
+struct BenchResult {
+    QString name;
+    bool success = false;
+    qint64 wallMs = 0;
+    qint64 rows = 0;
+    qint64 outputBytes = 0;
+    qint64 peakRssKb = -1;
+};
+
+// 重置峰值常驻内存（Linux 4.0+），使每项测量的峰值互不影响；其他平台只能取进程级峰值
+void resetPeakRss()
+{
+#ifdef Q_OS_LINUX
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+}
+
+qint64 peakRssKb()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+            }
+        }
+    }
+#endif
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MACOS
+        return usage.ru_maxrss / 1024; // macOS 单位为字节
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+QString randomText(QRandomGenerator& random, int length)
+{
+    static const QString alphabet = QStringLiteral("任务计划会议报告整理审核设计开发测试部署文档客户需求进度总结abcdefghijklmnopqrstuvwxyz0123456789 ");
+    QString text;
+    text.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        text += alphabet.at(random.bounded(alphabet.size()));
+    }
+    return text;
+}
+
+int pickPriority(QRandomGenerator& random, const QVector<int>& weights)
+{
+    int total = 0;
+    for (int weight : weights) {
+        total += weight;
+    }
+    int value = random.bounded(qMax(1, total));
+    for (int i = 0; i < weights.size(); ++i) {
+        if (value < weights[i]) {
+            return i;
+        }
+        value -= weights[i];
+    }
+    return Low;
+}
+
+// 生成合成数据库：分类数、优先级分布、描述长度、完成比例均可配置，相同种子结果一致
+bool generateDatabase(const GeneratorConfig& config)
+{
+    TaskDatabase* db = TaskDatabase::getInstance();
+    if (!db->init()) {
+        return false;
+    }
+
+    QSqlDatabase connection = db->getDatabaseConnection();
+    QRandomGenerator random(config.seed);
+
+    QVector<int> categoryIds;
+    QSqlQuery categoryQuery("SELECT id FROM categories ORDER BY id", connection);
+    while (categoryQuery.next()) {
+        categoryIds.append(categoryQuery.value(0).toInt());
+    }
+    QSqlQuery insertCategory(connection);
+    insertCategory.prepare("INSERT INTO categories (name) VALUES (:name)");
+    while (categoryIds.size() < config.categories) {
+        insertCategory.bindValue(":name", QString("分类%1").arg(categoryIds.size() + 1));
+        if (!insertCategory.exec()) {
+            qCritical() << "生成分类失败：" << insertCategory.lastError().text();
+            return false;
+        }
+        categoryIds.append(insertCategory.lastInsertId().toInt());
+    }
+    categoryIds.resize(qMin(categoryIds.size(), qMax(1, config.categories)));
+
+    const QDateTime base(QDate(2024, 1, 1), QTime(9, 0));
+    connection.transaction();
+    QSqlQuery insertTask(connection);
+    insertTask.prepare(R"(
+        INSERT INTO tasks (title, description, category_id, priority, deadline, completed, create_time)
+        VALUES (:title, :desc, :cat_id, :priority, :deadline, :completed, :create_time)
+    )");
+    for (int i = 0; i < config.rows; ++i) {
+        const int descriptionLength = config.descriptionMin
+                                      + random.bounded(qMax(1, config.descriptionMax - config.descriptionMin + 1));
+        const QVariant categoryId = random.generateDouble() < config.uncategorizedRatio
+                                        ? QVariant()
+                                        : QVariant(categoryIds[random.bounded(categoryIds.size())]);
+        // 约 10% 的任务没有截止时间
+        const QVariant deadline = random.bounded(10) == 0
+                                      ? QVariant()
+                                      : QVariant(base.addSecs(qint64(random.bounded(365 * 24)) * 3600));
+        insertTask.bindValue(":title", QString("任务%1 ").arg(i + 1) + randomText(random, 4 + random.bounded(16)));
+        insertTask.bindValue(":desc", randomText(random, descriptionLength));
+        insertTask.bindValue(":cat_id", categoryId);
+        insertTask.bindValue(":priority", pickPriority(random, config.priorityWeights));
+        insertTask.bindValue(":deadline", deadline);
+        insertTask.bindValue(":completed", random.generateDouble() < config.completedRatio);
+        insertTask.bindValue(":create_time", base.addSecs(-qint64(random.bounded(365 * 24)) * 3600));
+        if (!insertTask.exec()) {
+            qCritical() << "生成任务失败：" << insertTask.lastError().text();
+            connection.rollback();
+            return false;
+        }
+    }
+    return connection.commit();
+}
+
+template <typename Function>
+BenchResult measure(const QString& name, const QStringList& outputs, Function run)
+{
+    for (const QString& output : outputs) {
+        QFile::remove(output);
+    }
+    resetPeakRss();
+
+    BenchResult result;
+    result.name = name;
+    ExportProgress progress;
+    QElapsedTimer timer;
+    timer.start();
+    result.success = run(&progress);
+    result.wallMs = timer.elapsed();
+    result.peakRssKb = peakRssKb();
+    result.rows = progress.rows.load();
+    for (const QString& output : outputs) {
+        result.outputBytes += QFileInfo(output).size();
+    }
+
+    QTextStream(stderr) << name << ": " << result.wallMs << " ms, " << result.rows << " rows, "
+                        << result.outputBytes << " bytes" << (result.success ? "" : " (失败)") << "\n";
+    return result;
+}
+
+QJsonObject toJson(const BenchResult& result)
+{
+    QJsonObject object;
+    object["name"] = result.name;
+    object["success"] = result.success;
+    object["wallMs"] = result.wallMs;
+    object["rows"] = result.rows;
+    object["rowsPerSec"] = result.wallMs > 0 ? result.rows * 1000.0 / result.wallMs : 0.0;
+    object["peakRssKb"] = result.peakRssKb;
+    object["outputBytes"] = result.outputBytes;
+    return object;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    // QPrinter 需要图形应用对象；无显示环境可用 QT_QPA_PLATFORM=offscreen 运行
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("export_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("任务导出性能基准");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"rows", "生成的任务数", "n", "100000"},
+        {"categories", "分类数", "n", "8"},
+        {"priority-weights", "低,中,高优先级权重", "l,m,h", "5,3,2"},
+        {"desc-min", "描述最短字符数", "n", "0"},
+        {"desc-max", "描述最长字符数", "n", "200"},
+        {"completed-ratio", "已完成任务比例", "ratio", "0.3"},
+        {"seed", "随机种子", "n", "1"},
+        {"work-dir", "数据库与导出文件目录", "dir", QDir::temp().filePath("export_bench")},
+        {"benchmarks", "要运行的项目：excel,pdf,sinks,delta", "list", "excel,pdf,sinks,delta"},
+        {"json", "结果输出文件（默认标准输出）", "file"},
+        {"reuse-db", "目录中已有数据库时直接使用，不重新生成"},
+    });
+    parser.process(app);
+
+    GeneratorConfig config;
+    config.rows = parser.value("rows").toInt();
+    config.categories = parser.value("categories").toInt();
+    config.priorityWeights.clear();
+    for (const QString& weight : parser.value("priority-weights").split(',')) {
+        config.priorityWeights.append(weight.toInt());
+    }
+    config.descriptionMin = parser.value("desc-min").toInt();
+    config.descriptionMax = qMax(config.descriptionMin, parser.value("desc-max").toInt());
+    config.completedRatio = parser.value("completed-ratio").toDouble();
+    config.seed = parser.value("seed").toUInt();
+
+    QDir workDir(parser.value("work-dir"));
+    workDir.mkpath(".");
+    const QString dbPath = workDir.filePath("task_manager.db");
+    TaskDatabase::getInstance()->setDatabasePath(dbPath);
+
+    qint64 generateMs = 0;
+    if (!parser.isSet("reuse-db") || !QFileInfo::exists(dbPath)) {
+        QFile::remove(dbPath);
+        QFile::remove(dbPath + "-wal");
+        QFile::remove(dbPath + "-shm");
+        QElapsedTimer timer;
+        timer.start();
+        if (!generateDatabase(config)) {
+            QTextStream(stderr) << "生成数据库失败\n";
+            return 1;
+        }
+        generateMs = timer.elapsed();
+    }
+
+    const QStringList benchmarks = parser.value("benchmarks").split(',');
+    ExportManager exporter;
+    QJsonArray results;
+
+    if (benchmarks.contains("excel")) {
+        const QString output = workDir.filePath("tasks.xlsx");
+        results.append(toJson(measure("excel", {output}, [&](ExportProgress* progress) {
+            return exporter.exportToExcel(output, progress);
+        })));
+    }
+
+    if (benchmarks.contains("pdf")) {
+        const QString output = workDir.filePath("tasks.pdf");
+        results.append(toJson(measure("pdf", {output}, [&](ExportProgress* progress) {
+            return exporter.exportToPdf(output, progress);
+        })));
+    }
+
+    const QStringList sinkOutputs = {workDir.filePath("tasks.csv"), workDir.filePath("tasks.jsonl"),
+                                     workDir.filePath("tasks_sinks.xlsx")};
+    auto runSinks = [&](ExportProgress* progress, qint64 sinceSeq, qint64* highWaterMark) {
+        CsvExportSink csv(sinkOutputs[0]);
+        JsonLinesExportSink jsonLines(sinkOutputs[1]);
+        XlsxExportSink xlsx(sinkOutputs[2]);
+        const QVector<ExportSink*> sinks = {&csv, &jsonLines, &xlsx};
+        if (highWaterMark) {
+            return exporter.exportChangesToSinks(sinks, sinceSeq, highWaterMark, progress);
+        }
+        return exporter.exportToSinks(sinks, progress);
+    };
+
+    if (benchmarks.contains("sinks")) {
+        results.append(toJson(measure("sinks", sinkOutputs, [&](ExportProgress* progress) {
+            return runSinks(progress, -1, nullptr);
+        })));
+    }
+
+    if (benchmarks.contains("delta")) {
+        // 先取当前高水位，再修改约 1% 的任务，测量增量导出
+        const qint64 sinceSeq = TaskDatabase::getInstance()->getLatestChangeSeq();
+        QSqlQuery update(TaskDatabase::getInstance()->getDatabaseConnection());
+        if (!update.exec("UPDATE tasks SET completed = 1 - completed WHERE id % 100 = 0")) {
+            QTextStream(stderr) << "修改任务失败：" << update.lastError().text() << "\n";
+        }
+        results.append(toJson(measure("delta", sinkOutputs, [&](ExportProgress* progress) {
+            qint64 highWaterMark = 0;
+            return runSinks(progress, sinceSeq, &highWaterMark);
+        })));
+    }
+
+    QJsonObject configJson;
+    configJson["rows"] = config.rows;
+    configJson["categories"] = config.categories;
+    configJson["priorityWeights"] = parser.value("priority-weights");
+    configJson["descriptionMin"] = config.descriptionMin;
+    configJson["descriptionMax"] = config.descriptionMax;
+    configJson["completedRatio"] = config.completedRatio;
+    configJson["seed"] = qint64(config.seed);
+    configJson["databaseBytes"] = QFileInfo(dbPath).size();
+    configJson["generateMs"] = generateMs;
+
+    QJsonObject report;
+    report["config"] = configJson;
+    report["qtVersion"] = QString(qVersion());
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "无法写入结果文件：" << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    for (const QJsonValue& result : results) {
+        if (!result.toObject()["success"].toBool()) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+# QXlsx 样式去重微基准：重复调用 Styles::addXfFormat，测量每次调用的耗时
+# 用法：qmake && make && ./format_bench --calls 1000000 --styles 64
+QT += core gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TARGET = format_bench
+TEMPLATE = app
+
+QXLSX_ROOT = $$PWD/../../QXlsx
+include($$QXLSX_ROOT/QXlsx.pri)
+
+SOURCES += main.cpp
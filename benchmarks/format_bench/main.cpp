@@ -0,0 +1,103 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+
+#include "xlsxformat.h"
+#include "xlsxstyles_p.h"
+
+using namespace QXlsx;
+
+namespace {
+
+// 第 i 种样式：字体、填充、边框、数字格式、对齐各自变化，组合出互不相同的格式
+Format makeFormat(int i)
+{
+    static const QColor colors[] = {Qt::black, Qt::red, Qt::darkGreen, Qt::blue};
+    Format format;
+    format.setFontBold(i & 1);
+    format.setFontItalic(i & 2);
+    format.setFontSize(10 + (i % 5));
+    format.setFontColor(colors[(i / 4) % 4]);
+    if (i & 8) {
+        format.setPatternBackgroundColor(QColor(0xf0, 0xf0, 0xf0 - (i % 16)));
+    }
+    if (i & 16) {
+        format.setBorderStyle(Format::BorderThin);
+    }
+    format.setNumberFormat((i & 32) ? QStringLiteral("yyyy-mm-dd") : QStringLiteral("0.00"));
+    format.setHorizontalAlignment((i & 64) ? Format::AlignHCenter : Format::AlignLeft);
+    return format;
+}
+
+template <typename Function>
+void measure(const QString& name, int calls, Function run)
+{
+    QElapsedTimer timer;
+    timer.start();
+    run();
+    const qint64 ns = timer.nsecsElapsed();
+    QTextStream(stderr) << name << ": " << ns / 1000000 << " ms, "
+                        << double(ns) / calls << " ns/call\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QXlsx 样式去重微基准");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"calls", "addXfFormat 调用次数（默认 1000000）", "n", "1000000"},
+        {"styles", "不同样式的数量（默认 64）", "n", "64"},
+    });
+    parser.process(app);
+
+    const int calls = qMax(1, parser.value("calls").toInt());
+    const int styleCount = qMax(1, parser.value("styles").toInt());
+
+    QVector<Format> formats;
+    for (int i = 0; i < styleCount; ++i) {
+        formats.append(makeFormat(i));
+    }
+
+    // 逐单元格写入的常见用法：每次复制调用方的 Format 再登记
+    {
+        Styles styles(Styles::F_NewFromScratch);
+        measure("addXfFormat (复用格式)", calls, [&] {
+            for (int i = 0; i < calls; ++i) {
+                Format format = formats[i % styleCount];
+                styles.addXfFormat(format);
+            }
+        });
+    }
+
+    // 每次新建格式，包含设置属性时的增量哈希开销
+    {
+        Styles styles(Styles::F_NewFromScratch);
+        measure("addXfFormat (新建格式)", calls, [&] {
+            for (int i = 0; i < calls; ++i) {
+                styles.addXfFormat(makeFormat(i % styleCount));
+            }
+        });
+    }
+
+    // 对照：旧的去重路径为每个新建格式序列化的四个字节数组键
+    {
+        qint64 keyBytes = 0;
+        measure("序列化键 (对照)", calls, [&] {
+            for (int i = 0; i < calls; ++i) {
+                const Format format = makeFormat(i % styleCount);
+                keyBytes += format.formatKey().size() + format.fontKey().size()
+                            + format.fillKey().size() + format.borderKey().size();
+            }
+        });
+        QTextStream(stderr) << "  键总长度: " << keyBytes << " bytes\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet.h"
+
+using namespace QXlsx;
+
+namespace {
+
+const int kColumnCount = 8;
+
+// 与任务导出相同的列：ID、标题、描述、分类、优先级、截止时间、状态、创建时间
+QVector<QVariant> makeRow(int i, const QDateTime& base)
+{
+    static const QString categories[] = {"工作", "学习", "生活", "未分类"};
+    static const QString priorities[] = {"低", "中", "高"};
+    return {
+        i,
+        QString("任务 %1").arg(i),
+        QString("合成任务描述 %1").arg(i % 1000),
+        categories[i % 4],
+        priorities[i % 3],
+        base.addSecs(qint64(i) * 3600),
+        (i % 5 == 0) ? QString("已完成") : QString("未完成"),
+        base.addSecs(-qint64(i) * 60),
+    };
+}
+
+template <typename Function>
+void measure(const QString& name, int rows, Function run)
+{
+    Document xlsx;
+    Worksheet* sheet = xlsx.currentWorksheet();
+
+    QElapsedTimer timer;
+    timer.start();
+    run(xlsx.workbook(), sheet);
+    const qint64 ns = timer.nsecsElapsed();
+    const double cells = double(rows) * kColumnCount;
+    QTextStream(stderr) << name << ": " << ns / 1000000 << " ms, "
+                        << cells * 1e9 / qMax<qint64>(ns, 1) << " cells/s\n";
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QXlsx 单元格写入吞吐基准");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"rows", "写入行数（默认 200000）", "n", "200000"},
+    });
+    parser.process(app);
+
+    const int rows = qMax(1, parser.value("rows").toInt());
+    const QDateTime base(QDate(2024, 1, 1), QTime(9, 0));
+
+    // 预先生成数据，只测量写入本身
+    QVector<QVector<QVariant>> data;
+    data.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        data.append(makeRow(i + 1, base));
+    }
+
+    Format dateFormat;
+    dateFormat.setNumberFormat("yyyy-mm-dd hh:mm");
+
+    // 基线：每个单元格调用一次 write，并传入 Format
+    measure("write (逐单元格)", rows, [&](Workbook*, Worksheet* sheet) {
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < kColumnCount; ++c) {
+                const bool isDate = (c == 5 || c == 7);
+                sheet->write(r + 1, c + 1, data[r][c], isDate ? dateFormat : Format());
+            }
+        }
+    });
+
+    // 整行写入：样式句柄只登记一次
+    measure("appendRow", rows, [&](Workbook* book, Worksheet* sheet) {
+        const int dateStyle = book->registerStyle(dateFormat);
+        const QVector<int> styles = {-1, -1, -1, -1, -1, dateStyle, -1, dateStyle};
+        for (int r = 0; r < rows; ++r) {
+            sheet->appendRow(data[r], styles);
+        }
+    });
+
+    // 按列写入：每列类型一致，整列只分派一次
+    measure("writeColumn", rows, [&](Workbook* book, Worksheet* sheet) {
+        const int dateStyle = book->registerStyle(dateFormat);
+        for (int c = 0; c < kColumnCount; ++c) {
+            switch (data[0][c].userType()) {
+            case QMetaType::Int: {
+                QVector<double> column(rows);
+                for (int r = 0; r < rows; ++r) {
+                    column[r] = data[r][c].toDouble();
+                }
+                sheet->writeColumn(1, c + 1, column);
+                break;
+            }
+            case QMetaType::QDateTime: {
+                QVector<QDateTime> column(rows);
+                for (int r = 0; r < rows; ++r) {
+                    column[r] = data[r][c].toDateTime();
+                }
+                sheet->writeColumn(1, c + 1, column, dateStyle);
+                break;
+            }
+            default: {
+                QStringList column;
+                column.reserve(rows);
+                for (int r = 0; r < rows; ++r) {
+                    column.append(data[r][c].toString());
+                }
+                sheet->writeColumn(1, c + 1, column);
+                break;
+            }
+            }
+        }
+    });
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+# QXlsx 写入吞吐基准：按任务导出的表格形状写入合成数据，对比逐单元格写入与整行、整列写入
+# 用法：qmake && make && ./write_bench --rows 200000
+QT += core gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TARGET = write_bench
+TEMPLATE = app
+
+QXLSX_ROOT = $$PWD/../../QXlsx
+include($$QXLSX_ROOT/QXlsx.pri)
+
+SOURCES += main.cpp
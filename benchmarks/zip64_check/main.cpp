@@ -0,0 +1,195 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <memory>
+
+#include "xlsxzipreader_p.h"
+#include "xlsxzipwriter_p.h"
+
+using namespace QXlsx;
+
+namespace {
+
+const qint64 kMiB = 1024 * 1024;
+
+// 一行合成的 sheetData XML，与任务导出的行形状相近
+QByteArray makeRow(qint64 row)
+{
+    return "<row r=\"" + QByteArray::number(row) + "\"><c r=\"A" + QByteArray::number(row)
+           + "\"><v>" + QByteArray::number(row) + "</v></c><c r=\"B" + QByteArray::number(row)
+           + "\" t=\"s\"><v>" + QByteArray::number(row % 1000) + "</v></c></row>";
+}
+
+QString smallEntryName(int i)
+{
+    return QStringLiteral("xl/small/part%1.xml").arg(i);
+}
+
+QByteArray smallEntryData(int i)
+{
+    return "<part>" + QByteArray::number(i) + "</part>";
+}
+
+bool fail(const QString& message)
+{
+    QTextStream(stderr) << "失败: " << message << "\n";
+    return false;
+}
+
+// 写入：大条目之后再写小条目；归档超过 4 GB 时它们的本地头偏移、中央目录偏移
+// 都需要 ZIP64 字段，并写出 ZIP64 结束记录与定位器
+bool writeArchive(const QString& path, qint64 hugeSize, int entries, int level, qint64* written)
+{
+    ZipWriter writer(path);
+    writer.setCompressionLevel(level);
+    writer.addFile(QStringLiteral("[Content_Types].xml"), QByteArray("<Types/>"));
+
+    QIODevice* sheet = writer.openFile(QStringLiteral("xl/worksheets/sheet1.xml"));
+    QByteArray chunk;
+    qint64 row = 1;
+    *written = 0;
+    while (*written < hugeSize) {
+        chunk.clear();
+        while (chunk.size() < kMiB) {
+            chunk += makeRow(row++);
+        }
+        const qint64 take = qMin<qint64>(chunk.size(), hugeSize - *written);
+        sheet->write(chunk.constData(), take);
+        *written += take;
+    }
+    writer.closeFile();
+
+    for (int i = 0; i < entries; ++i) {
+        writer.addFile(smallEntryName(i), smallEntryData(i));
+    }
+    writer.close();
+    return !writer.error();
+}
+
+bool verifyArchive(const QString& path, qint64 hugeSize, int entries)
+{
+    ZipReader reader(path);
+    if (!reader.exists()) {
+        return fail("无法读取中央目录");
+    }
+    if (reader.filePaths().size() != entries + 2) {
+        return fail(QString("条目数为 %1，应为 %2").arg(reader.filePaths().size()).arg(entries + 2));
+    }
+    const qint64 size = reader.fileSize(QStringLiteral("xl/worksheets/sheet1.xml"));
+    if (size != hugeSize) {
+        return fail(QString("大条目大小为 %1，应为 %2").arg(size).arg(hugeSize));
+    }
+    // 流式读回大条目：逐块解压并在末尾校验 CRC，内存占用与条目大小无关
+    const std::unique_ptr<QIODevice> sheet = reader.openFile(QStringLiteral("xl/worksheets/sheet1.xml"));
+    if (!sheet) {
+        return fail("无法打开大条目");
+    }
+    QByteArray buffer(int(kMiB), Qt::Uninitialized);
+    qint64 streamed = 0;
+    for (;;) {
+        const qint64 n = sheet->read(buffer.data(), buffer.size());
+        if (n < 0) {
+            return fail(QString("流式读取出错: %1").arg(sheet->errorString()));
+        }
+        if (n == 0) {
+            break;
+        }
+        streamed += n;
+    }
+    if (streamed != hugeSize) {
+        return fail(QString("流式读取 %1 字节，应为 %2").arg(streamed).arg(hugeSize));
+    }
+    if (reader.fileData(QStringLiteral("[Content_Types].xml")) != "<Types/>") {
+        return fail("首个条目内容不一致");
+    }
+    // 抽查小条目，包括最后一个
+    for (int i = 0; i < entries; i += qMax(1, entries / 100)) {
+        if (reader.fileData(smallEntryName(i)) != smallEntryData(i)) {
+            return fail(QString("条目 %1 内容不一致").arg(smallEntryName(i)));
+        }
+    }
+    if (entries > 0 && reader.fileData(smallEntryName(entries - 1)) != smallEntryData(entries - 1)) {
+        return fail("最后一个条目内容不一致");
+    }
+    return true;
+}
+
+// 用外部工具 unzip -t 逐条目解压并校验 CRC，不依赖本库的 ZipReader
+bool verifyWithUnzip(const QString& program, const QString& path)
+{
+    QProcess unzip;
+    unzip.setProcessChannelMode(QProcess::ForwardedChannels);
+    unzip.start(program, {"-tqq", path});
+    if (!unzip.waitForStarted()) {
+        return fail(QString("无法启动 %1: %2").arg(program, unzip.errorString()));
+    }
+    unzip.waitForFinished(-1);
+    if (unzip.exitStatus() != QProcess::NormalExit || unzip.exitCode() != 0) {
+        return fail(QString("%1 -t 校验失败，退出码 %2").arg(program).arg(unzip.exitCode()));
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QXlsx ZIP64 往返校验");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"size", "合成工作表条目的大小，单位 GB（默认 5）", "gb", "5"},
+        {"entries", "大条目之后的小条目数量（默认 70000）", "n", "70000"},
+        {"level", "压缩级别（默认 0，即存储，归档本身才会超过 4 GB）", "level", "0"},
+        {"keep", "保留生成的归档，便于用其他外部工具再校验", "path"},
+        {"unzip", "读回之后再用外部 unzip -t 校验归档（可指定 unzip 程序路径）", "program"},
+    });
+    parser.process(app);
+
+    const qint64 hugeSize = qMax<qint64>(1, qRound64(parser.value("size").toDouble() * 1024 * kMiB));
+    const int entries = qMax(0, parser.value("entries").toInt());
+    const int level = parser.value("level").toInt();
+
+    QTemporaryDir dir;
+    const QString path = parser.isSet("keep") ? parser.value("keep") : dir.filePath("zip64.xlsx");
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 written = 0;
+    if (!writeArchive(path, hugeSize, entries, level, &written)) {
+        fail("写入归档出错");
+        return 1;
+    }
+    QTextStream(stderr) << "写入: " << written / kMiB << " MB, " << timer.elapsed() << " ms\n";
+
+    // 压缩后的归档不足 4 GB 时偏移与结束记录都不需要 ZIP64，校验没有意义
+    const qint64 archiveSize = QFileInfo(path).size();
+    if (archiveSize <= 0xFFFFFFFFLL) {
+        fail(QString("归档只有 %1 MB，未超过 4 GB，无法覆盖 ZIP64 偏移；请使用 --level 0 或增大 --size")
+                 .arg(archiveSize / kMiB));
+        return 1;
+    }
+
+    timer.restart();
+    if (!verifyArchive(path, hugeSize, entries)) {
+        return 1;
+    }
+    QTextStream(stderr) << "读回: " << timer.elapsed() << " ms\n";
+
+    if (parser.isSet("unzip")) {
+        timer.restart();
+        if (!verifyWithUnzip(parser.value("unzip"), path)) {
+            return 1;
+        }
+        QTextStream(stderr) << "unzip -t: " << timer.elapsed() << " ms\n";
+    }
+    QTextStream(stderr) << "通过\n";
+    return 0;
+}
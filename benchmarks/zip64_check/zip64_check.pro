@@ -0,0 +1,13 @@
+# ZIP64 往返校验：流式写入一个数 GB 的合成工作表条目和超过 65535 个小条目，再用 ZipReader 读回核对
+# 用法：qmake && make && ./zip64_check --size 5 --entries 70000 [--level 0] [--keep out.zip] [--unzip unzip]
+# --unzip 在读回之后再用外部 unzip -t 校验，确认其他实现也能读取本库写出的 ZIP64 归档
+QT += core gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TARGET = zip64_check
+TEMPLATE = app
+
+QXLSX_ROOT = $$PWD/../../QXlsx
+include($$QXLSX_ROOT/QXlsx.pri)
+
+SOURCES += main.cpp
@@ -1,13 +1,16 @@
 #include "mainwindow.h"
 #include "TaskDatabase.h"
+#include "StartupTrace.h"
 #include <QApplication>
 #include <QLocale>
 #include <QTranslator>
 #include <QMessageBox>
 #include <QDebug>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::start();
     QApplication a(argc, argv);
 
     // 检查SQLite驱动是否可用
@@ -38,7 +41,10 @@ int main(int argc, char *argv[])
         }
     }
 
+    // 窗口先显示，任务数据由 MainWindow 在后台加载
     MainWindow w;
     w.show();
+    // 事件循环处理完首批事件（含首次绘制）即视为窗口可用
+    QTimer::singleShot(0, &w, [] { StartupTrace::mark("窗口可用"); });
     return a.exec();
 }
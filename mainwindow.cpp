@@ -1,7 +1,10 @@
 // MainWindow.cpp
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include "StartupTrace.h"
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QStatusBar>
 #include <QDateTime>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -14,6 +17,11 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 取消并等待后台导出结束，导出线程不会比窗口活得更久
+    if (m_exportJob) {
+        m_exportJob->cancel();
+        m_exportJob->wait();
+    }
     m_reminderWorker->quit();
     m_reminderWorker->wait();
     delete ui;
@@ -21,50 +29,64 @@ MainWindow::~MainWindow()
 
 void MainWindow::initUI()
 {
-    // 初始化数据库
-    if (!TaskDatabase::getInstance()->init()) {
-        QMessageBox::critical(this, "错误", "数据库初始化失败，程序将退出！");
-        qApp->quit();
-    }
-
-    // 初始化Model/View
-    m_taskModel = new TaskModel(this, TaskDatabase::getInstance()->database());
-    m_proxyModel = new QSortFilterProxyModel(this);
-    m_proxyModel->setSourceModel(m_taskModel);
-    m_proxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive); // 不区分大小写过滤
-    ui->taskTable->setModel(m_proxyModel);
+    // 数据库已在 main() 中初始化
+
+    // 初始化Model/View：任务数据在后台加载，先显示首屏所在的一页
+    m_taskModel = new TaskTableModel(this);
+    connect(m_taskModel, &TaskTableModel::firstRowsLoaded, this, &MainWindow::onFirstRowsLoaded);
+    m_taskModel->selectAsync();
+    ui->taskTable->setModel(m_taskModel);
+    ui->taskTable->horizontalHeader()->setSortIndicator(TaskTableModel::DeadlineColumn, Qt::AscendingOrder);
+    ui->taskTable->setSortingEnabled(true); // 点击列头排序，由数据库按新顺序分页读取
     ui->taskTable->setColumnHidden(0, true); // 隐藏ID列
     ui->taskTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch); // 列宽自适应
     ui->taskTable->setSelectionBehavior(QAbstractItemView::SelectRows); // 整行选择
+    ui->taskTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed); // 固定行高，大表滚动无需逐行测量
+
+    // 初始化后台搜索
+    m_searchEngine = new TaskSearchEngine(this);
+    connect(m_searchEngine, &TaskSearchEngine::resultsReady, this, &MainWindow::applySearchResult);
+    connect(m_searchEngine, &TaskSearchEngine::metricsChanged, this, [this](const SearchMetrics& metrics) {
+        statusBar()->showMessage(QString("搜索耗时 %1 ms（平均 %2 ms），已取消 %3 次")
+                                     .arg(metrics.lastLatencyMs)
+                                     .arg(metrics.averageLatencyMs(), 0, 'f', 1)
+                                     .arg(metrics.cancelled));
+    });
 
     // 初始化优先级过滤下拉框
-    ui->priorityCombo->addItem("全部优先级");
-    ui->priorityCombo->addItem("低优先级");
-    ui->priorityCombo->addItem("中优先级");
-    ui->priorityCombo->addItem("高优先级");
+    ui->priorityCombo->addItem("全部优先级", -1);
+    ui->priorityCombo->addItem("低优先级", Low);
+    ui->priorityCombo->addItem("中优先级", Medium);
+    ui->priorityCombo->addItem("高优先级", High);
 
     // 加载分类列表
     loadCategories();
 
-    // 初始化后台提醒线程
+    // 初始化后台提醒线程（首屏数据显示后再启动）
     m_reminderWorker = new ReminderWorker();
     connect(m_reminderWorker, &ReminderWorker::reminderTriggered, this, &MainWindow::showReminder);
-    m_reminderWorker->start();
-
-    // 初始化导出管理器
-    m_exportManager = new ExportManager();
 
     // 设置窗口标题
     setWindowTitle("个人工作与任务管理系统");
 }
 
+void MainWindow::onFirstRowsLoaded()
+{
+    StartupTrace::mark("首行数据");
+    if (!m_reminderWorker->isRunning()) {
+        m_reminderWorker->start();
+    }
+}
+
 void MainWindow::loadCategories()
 {
     ui->categoryList->clear();
-    ui->categoryList->addItem("全部分类");
+    QListWidgetItem* allItem = new QListWidgetItem("全部分类", ui->categoryList);
+    allItem->setData(Qt::UserRole, -1);
     QList<Category> categories = TaskDatabase::getInstance()->getAllCategories();
     for (const Category& cat : categories) {
-        ui->categoryList->addItem(cat.name);
+        QListWidgetItem* item = new QListWidgetItem(cat.name, ui->categoryList);
+        item->setData(Qt::UserRole, cat.id);
     }
     ui->categoryList->setCurrentRow(0);
 }
@@ -184,9 +206,7 @@ void MainWindow::on_editTaskBtn_clicked()
         return;
     }
 
-    QModelIndex proxyIndex = selectedRows.first();
-    QModelIndex sourceIndex = m_proxyModel->mapToSource(proxyIndex);
-    int taskId = m_taskModel->data(m_taskModel->index(sourceIndex.row(), 0)).toInt();
+    int taskId = m_taskModel->taskId(selectedRows.first().row());
 
     // 获取当前任务
     QList<Task> tasks = TaskDatabase::getInstance()->getAllTasks();
@@ -220,9 +240,7 @@ void MainWindow::on_deleteTaskBtn_clicked()
         return;
     }
 
-    QModelIndex proxyIndex = selectedRows.first();
-    QModelIndex sourceIndex = m_proxyModel->mapToSource(proxyIndex);
-    int taskId = m_taskModel->data(m_taskModel->index(sourceIndex.row(), 0)).toInt();
+    int taskId = m_taskModel->taskId(selectedRows.first().row());
 
     if (TaskDatabase::getInstance()->deleteTask(taskId)) {
         QMessageBox::information(this, "成功", "任务删除成功！");
@@ -240,10 +258,9 @@ void MainWindow::on_markCompletedBtn_clicked()
         return;
     }
 
-    QModelIndex proxyIndex = selectedRows.first();
-    QModelIndex sourceIndex = m_proxyModel->mapToSource(proxyIndex);
-    int taskId = m_taskModel->data(m_taskModel->index(sourceIndex.row(), 0)).toInt();
-    bool isCompleted = m_taskModel->data(m_taskModel->index(sourceIndex.row(), 6)).toBool();
+    const int row = selectedRows.first().row();
+    int taskId = m_taskModel->taskId(row);
+    bool isCompleted = m_taskModel->isCompleted(row);
 
     if (TaskDatabase::getInstance()->markTaskCompleted(taskId, !isCompleted)) {
         QMessageBox::information(this, "成功", "任务状态更新成功！");
@@ -260,11 +277,7 @@ void MainWindow::on_exportExcelBtn_clicked()
         return;
     }
 
-    if (m_exportManager->exportToExcel(filePath)) {
-        QMessageBox::information(this, "成功", "Excel报表导出成功！");
-    } else {
-        QMessageBox::warning(this, "失败", "Excel报表导出失败！");
-    }
+    startExport(ExportJob::ExcelFormat, filePath);
 }
 
 void MainWindow::on_exportPdfBtn_clicked()
@@ -274,39 +287,89 @@ void MainWindow::on_exportPdfBtn_clicked()
         return;
     }
 
-    if (m_exportManager->exportToPdf(filePath)) {
-        QMessageBox::information(this, "成功", "PDF报表导出成功！");
-    } else {
-        QMessageBox::warning(this, "失败", "PDF报表导出失败！");
+    startExport(ExportJob::PdfFormat, filePath);
+}
+
+void MainWindow::startExport(ExportJob::Format format, const QString& filePath)
+{
+    if (m_exportJob) {
+        QMessageBox::warning(this, "提示", "已有导出任务正在进行！");
+        return;
+    }
+
+    ui->exportExcelBtn->setEnabled(false);
+    ui->exportPdfBtn->setEnabled(false);
+
+    m_exportJob = new ExportJob(format, filePath, this);
+    connect(m_exportJob, &ExportJob::progressChanged, this, &MainWindow::onExportProgress);
+    connect(m_exportJob, &ExportJob::finished, this, &MainWindow::onExportFinished);
+
+    // 非模态进度框：导出期间界面仍可正常操作；导出的是全部任务，与表格当前的过滤条件无关
+    const int totalTasks = TaskDatabase::getInstance()->getTotalTaskCount();
+    m_exportDialog = new QProgressDialog("正在导出报表…", "取消", 0, qMax(1, totalTasks), this);
+    m_exportDialog->setWindowModality(Qt::NonModal);
+    m_exportDialog->setMinimumDuration(500);
+    m_exportDialog->setAutoClose(false);
+    m_exportDialog->setAutoReset(false);
+    m_exportDialog->setValue(0);
+    connect(m_exportDialog, &QProgressDialog::canceled, m_exportJob, &ExportJob::cancel);
+
+    m_exportJob->start();
+}
+
+void MainWindow::onExportProgress(qint64 rows, qint64 bytes)
+{
+    if (m_exportDialog) {
+        m_exportDialog->setValue(int(qMin<qint64>(rows, m_exportDialog->maximum())));
+        m_exportDialog->setLabelText(QString("正在导出报表…已处理 %1 行，已写入 %2 KB").arg(rows).arg(bytes / 1024));
     }
 }
 
-void MainWindow::on_categoryList_itemClicked(QListWidgetItem *item)
+void MainWindow::onExportFinished(bool success, bool cancelled)
 {
-    QString category = item->text();
-    if (category == "全部分类") {
-        m_proxyModel->setFilterFixedString(""); // 清空分类过滤
+    const bool excel = m_exportJob->format() == ExportJob::ExcelFormat;
+    m_exportJob->deleteLater();
+    m_exportJob = nullptr;
+    m_exportDialog->deleteLater();
+    m_exportDialog = nullptr;
+    ui->exportExcelBtn->setEnabled(true);
+    ui->exportPdfBtn->setEnabled(true);
+
+    if (cancelled) {
+        statusBar()->showMessage("报表导出已取消", 3000);
+    } else if (success) {
+        QMessageBox::information(this, "成功", excel ? "Excel报表导出成功！" : "PDF报表导出成功！");
     } else {
-        m_proxyModel->setFilterKeyColumn(3); // 按分类列过滤
-        m_proxyModel->setFilterFixedString(category);
+        QMessageBox::warning(this, "失败", excel ? "Excel报表导出失败！" : "PDF报表导出失败！");
     }
 }
 
+void MainWindow::on_categoryList_itemClicked(QListWidgetItem *item)
+{
+    TaskFilter filter = m_taskModel->filter();
+    filter.categoryId = item->data(Qt::UserRole).toInt(); // -1 为全部分类
+    m_taskModel->setFilter(filter);
+}
+
 void MainWindow::on_searchEdit_textChanged(const QString &text)
 {
-    m_proxyModel->setFilterKeyColumn(-1); // 全列搜索
-    m_proxyModel->setFilterFixedString(text);
+    // 匹配在后台完成，结果通过 applySearchResult 应用
+    m_searchEngine->search(text.trimmed());
+}
+
+void MainWindow::applySearchResult(const QString& text, TaskSearchEngine::IdList ids)
+{
+    TaskFilter filter = m_taskModel->filter();
+    filter.text = text;
+    filter.matchingIds = ids;
+    m_taskModel->setFilter(filter);
 }
 
 void MainWindow::on_priorityCombo_currentIndexChanged(int index)
 {
-    if (index == 0) {
-        m_proxyModel->setFilterFixedString(""); // 全部优先级
-    } else {
-        QString priorityText = ui->priorityCombo->itemText(index);
-        m_proxyModel->setFilterKeyColumn(4); // 按优先级列过滤
-        m_proxyModel->setFilterFixedString(priorityText);
-    }
+    TaskFilter filter = m_taskModel->filter();
+    filter.priority = ui->priorityCombo->itemData(index).toInt(); // -1 为全部优先级
+    m_taskModel->setFilter(filter);
 }
 
 void MainWindow::showReminder(const QList<Task>& tasks)
@@ -336,4 +399,8 @@ bool MainWindow::showTaskEditDialog(Task& task, bool isEdit)
 void MainWindow::refreshTaskTable()
 {
     m_taskModel->select();
+    // 任务有增删改时，重新计算搜索命中
+    if (!ui->searchEdit->text().trimmed().isEmpty()) {
+        m_searchEngine->search(ui->searchEdit->text().trimmed());
+    }
 }
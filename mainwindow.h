@@ -3,16 +3,18 @@
 #include <QListWidgetItem>
 #include <QMainWindow>
 #include <QSqlTableModel>
-#include <QSortFilterProxyModel>
 #include <QDialog>
 #include <QLineEdit>
 #include <QComboBox>
 #include <QDateTimeEdit>
 #include <QTextEdit>
 #include <QMessageBox>
-#include "TaskModel.h"
+#include "TaskTableModel.h"
+#include "TaskSearchEngine.h"
 #include "ReminderWorker.h"
-#include "ExportManager.h"
+#include "ExportJob.h"
+
+class QProgressDialog;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -47,12 +49,23 @@ private slots:
     // 提醒信号槽函数
     void showReminder(const QList<Task>& tasks);
 
+    // 启动时首屏数据加载完成
+    void onFirstRowsLoaded();
+
+    // 后台搜索结果：一次性应用到任务模型的过滤条件
+    void applySearchResult(const QString& text, TaskSearchEngine::IdList ids);
+
+    // 后台导出进度与完成通知
+    void onExportProgress(qint64 rows, qint64 bytes);
+    void onExportFinished(bool success, bool cancelled);
+
 private:
     Ui::MainWindow *ui;
-    TaskModel* m_taskModel;
-    QSortFilterProxyModel* m_proxyModel; // 过滤/排序代理模型
+    TaskTableModel* m_taskModel; // 排序、过滤都在数据库中完成
+    TaskSearchEngine* m_searchEngine; // 后台搜索（防抖 + 取消过期查询）
     ReminderWorker* m_reminderWorker;
-    ExportManager* m_exportManager;
+    ExportJob* m_exportJob = nullptr; // 当前后台导出任务，同一时间只允许一个
+    QProgressDialog* m_exportDialog = nullptr;
 
     // 初始化UI
     void initUI();
@@ -63,6 +76,9 @@ private:
     // 刷新任务表格
     void refreshTaskTable();
 
+    // 启动后台导出并显示进度
+    void startExport(ExportJob::Format format, const QString& filePath);
+
     // 显示任务编辑对话框（添加/编辑共用）
     bool showTaskEditDialog(Task& task, bool isEdit = false);
 };